@@ -0,0 +1,45 @@
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+struct AsyncIOOptions
+{
+    int queue_depth = 32;         // gleichzeitig ausstehende Lese-/Schreibaufträge
+    std::string backend = "auto"; // auto, uring, threads
+    int buffer_mb = 256;          // Obergrenze für alle Puffer zusammen, begrenzt die Tiefe bei großen Chunks
+};
+
+// Asynchrone Datei-I/O auf einem festen Satz Puffer (einer pro Warteschlangenplatz).
+// submit_* und wait/poll werden nur von einem Koordinator-Thread aufgerufen.
+class AsyncIO
+{
+public:
+    virtual ~AsyncIO() = default;
+
+    virtual const char *name() const = 0;
+    virtual int depth() const = 0;
+    virtual size_t buffer_size() const = 0;
+    virtual uint8_t *buffer(int slot) = 0;
+    // NUMA-Knoten, auf dem der Puffer liegt (Index wie bei ThreadPool::enqueue)
+    virtual int buffer_node(int slot) const = 0;
+
+    virtual bool submit_read(int fd, int slot, size_t len, off_t offset, uint64_t tag) = 0;
+    virtual bool submit_write(int fd, int slot, size_t len, off_t offset, uint64_t tag) = 0;
+
+    // Liefert einen abgeschlossenen Auftrag; result ist die Byteanzahl oder -errno
+    virtual bool wait(uint64_t &tag, int &result) = 0;
+    virtual bool poll(uint64_t &tag, int &result) = 0;
+};
+
+bool is_known_io_backend(const std::string &backend);
+
+// io_uring mit registrierten Puffern, bei Bedarf Rückfall auf einen Thread-Pool mit pread/pwrite.
+// Jeder Platz braucht buffer_size Bytes; reicht buffer_mb nicht für queue_depth Plätze, sinkt die Tiefe.
+std::unique_ptr<AsyncIO> create_async_io(const AsyncIOOptions &options, size_t buffer_size);
+
+#endif // ASYNC_IO_HPP
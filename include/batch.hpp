@@ -0,0 +1,23 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <string>
+#include <vector>
+#include "encoder.hpp"
+#include "kernel.hpp"
+
+struct BatchJob
+{
+    double x_min, x_max, y_min, y_max;
+    int width, height, max_iter;
+    std::string output;
+};
+
+// Liest eine JSON-Lines-Datei; fehlende Felder werden aus defaults übernommen
+std::vector<BatchJob> load_batch_jobs(const std::string &path, const BatchJob &defaults);
+
+// Rendert alle Aufträge über einen gemeinsamen Worker-Pool und schreibt einen Zeitbericht (CSV)
+bool run_batch(std::vector<BatchJob> jobs, int chunk_size, int num_workers, const EncoderOptions &encoder_options,
+               const FractalParams &fractal, const std::string &report_path, bool snap_to_grid);
+
+#endif // BATCH_HPP
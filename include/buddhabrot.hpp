@@ -0,0 +1,23 @@
+#ifndef BUDDHABROT_HPP
+#define BUDDHABROT_HPP
+
+#include <cstdint>
+#include <string>
+#include "encoder.hpp"
+#include "kernel.hpp"
+
+struct BuddhabrotOptions
+{
+    bool anti = false;          // Anti-Buddhabrot: Orbits der nicht entkommenden Punkte
+    int64_t samples = 10000000; // Anzahl der c-Werte
+    bool importance = true;     // c-Werte bevorzugt in Randnähe ziehen
+    int memory_mb = 1024;       // Obergrenze für alle Thread-Histogramme, darüber wird in Bändern gerendert
+    uint64_t seed = 1;
+};
+
+// Orbit-Dichte für z^d + c (Mandelbrot/Multibrot/Burning Ship), Julia wird nicht unterstützt
+bool generate_buddhabrot(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int num_workers,
+                         const FractalParams &fractal, const BuddhabrotOptions &options, const std::string &filename,
+                         const std::string &temp_dir, const EncoderOptions &encoder_options, bool silent);
+
+#endif // BUDDHABROT_HPP
@@ -2,7 +2,9 @@
 #define COMBINE_HPP
 
 #include <string>
+#include "encoder.hpp"
+#include "async_io.hpp"
 
-void write_image_chunked(const std::string &filename, int width, int height, int chunk_size, const std::string &temp_dir, int threads);
+void write_image_chunked(const std::string &filename, int width, int height, int chunk_size, const std::string &temp_dir, int threads, const EncoderOptions &encoder_options, const AsyncIOOptions &io_options);
 
 #endif // COMBINE_HPP
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef DISTANCE_HPP
+#define DISTANCE_HPP
+
+#include <string>
+#include "encoder.hpp"
+#include "kernel.hpp"
+
+struct DistanceOptions
+{
+    int supersample = 4;      // Subsamples pro Achse für Pixel, die nicht sicher außen liegen
+    double line_width = 1.0;  // Breite der Randlinie in Pixeln
+    std::string float_path;   // Distanzen in Pixeln als PFM (leer = aus)
+};
+
+// Außen-Distanzschätzung: Strichzeichnung über den Encoder, optional die Distanzen als Float-Daten
+bool generate_distance(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size,
+                       int num_workers, const FractalParams &fractal, const DistanceOptions &options, const std::string &filename,
+                       const EncoderOptions &encoder_options, bool silent);
+
+#endif // DISTANCE_HPP
@@ -0,0 +1,44 @@
+#ifndef ENCODER_HPP
+#define ENCODER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct EncoderOptions
+{
+    std::string format = "png"; // png, qoi, ppm, raw
+    int png_level = -1;         // zlib-Level 0-9, -1 = libpng-Standard
+    std::string png_strategy = "default"; // default, filtered, huffman, rle, fixed
+    std::string png_filters = "all";      // all, none, sub, up, avg, paeth (kombinierbar mit ',')
+};
+
+// Gemeinsame Schnittstelle für Chunk- und Enddateien. Zeilen werden als BGR (8 Bit) übergeben.
+class ImageEncoder
+{
+public:
+    virtual ~ImageEncoder() = default;
+
+    virtual std::string extension() const = 0;
+    virtual bool open(const std::string &path, int width, int height) = 0;
+    virtual bool write_row(const uint8_t *bgr) = 0;
+    virtual bool close() = 0;
+
+    // Dekodiert eine komplette Datei aus dem Speicher; width wird für das Rohformat benötigt
+    virtual cv::Mat decode(const uint8_t *data, size_t size, int width) const = 0;
+
+    bool write(const std::string &path, const cv::Mat &image);
+    cv::Mat read(const std::string &path, int width) const;
+};
+
+bool is_known_format(const std::string &format);
+bool is_known_png_strategy(const std::string &strategy);
+bool is_known_png_filters(const std::string &filters); // kommagetrennte Liste
+std::unique_ptr<ImageEncoder> create_encoder(const EncoderOptions &options);
+
+// Kodiert ein Bild mit allen Formaten und gibt Größe und Durchsatz aus
+void benchmark_encoders(const cv::Mat &image, const EncoderOptions &options, const std::string &temp_dir);
+
+#endif // ENCODER_HPP
@@ -0,0 +1,327 @@
+#ifndef KERNEL_HPP
+#define KERNEL_HPP
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+enum class Formula
+{
+    Mandelbrot,  // z^d + c, z0 = 0
+    Julia,       // z^d + k, z0 = Pixel
+    BurningShip, // (|Re z| + i|Im z|)^d + c, z0 = 0
+};
+
+struct FractalParams
+{
+    Formula formula = Formula::Mandelbrot;
+    int power = 2;
+    double julia_re = -0.8;
+    double julia_im = 0.156;
+};
+
+constexpr int KERNEL_MIN_POWER = 2;
+constexpr int KERNEL_MAX_POWER = 8;
+constexpr double DE_BAILOUT = 1000.0; // großer Radius, damit die Distanzschätzung trägt
+
+enum class KernelVariant
+{
+    Scalar, // ein Pixel, ohne SIMD
+    SSE2,   // zwei Pixel pro Register
+    SSE2x2, // zwei Register verschränkt (vier Pixel)
+};
+
+// Berechnet die Iterationen einer Bildzeile: Pixel x liegt bei (x0 + x * dx, y)
+using RowKernel = void (*)(double x0, double dx, double y, int width, int max_iter, const FractalParams &params, int *out);
+
+// Wählt einmal pro Render die passende Spezialisierung, nullptr bei ungültiger Potenz
+RowKernel select_kernel(const FractalParams &params);
+RowKernel select_kernel(const FractalParams &params, KernelVariant variant);
+
+// Distanzschätzung für beliebige Punkte (re[i], im[i]) in Einheiten der komplexen Ebene, 0 = nicht entkommen
+using DistanceKernel = void (*)(const double *re, const double *im, int count, int max_iter, const FractalParams &params, double *out);
+
+// nullptr für Burning Ship (nicht holomorph) und ungültige Potenzen
+DistanceKernel select_distance_kernel(const FractalParams &params);
+
+// Variante für select_kernel(params), z.B. aus --kernel oder dem Host-Profil
+void set_kernel_variant(KernelVariant variant);
+KernelVariant kernel_variant();
+const char *kernel_variant_name(KernelVariant variant);
+bool parse_kernel_variant(const std::string &name, KernelVariant &variant);
+std::string fractal_name(const FractalParams &params);
+
+namespace kernel
+{
+    // z^P per Quadrieren und Multiplizieren, zur Compilezeit vollständig ausgerollt
+    template <int P>
+    inline void complex_pow(__m128d &zr, __m128d &zi)
+    {
+        if constexpr (P == 1)
+        {
+            return;
+        }
+        else if constexpr (P % 2 == 0)
+        {
+            complex_pow<P / 2>(zr, zi);
+            __m128d r2 = _mm_mul_pd(zr, zr);
+            __m128d i2 = _mm_mul_pd(zi, zi);
+            __m128d ri = _mm_mul_pd(zr, zi);
+            zr = _mm_sub_pd(r2, i2);
+            zi = _mm_add_pd(ri, ri);
+        }
+        else
+        {
+            __m128d br = zr, bi = zi;
+            complex_pow<P - 1>(zr, zi);
+            __m128d r = _mm_sub_pd(_mm_mul_pd(zr, br), _mm_mul_pd(zi, bi));
+            __m128d i = _mm_add_pd(_mm_mul_pd(zr, bi), _mm_mul_pd(zi, br));
+            zr = r;
+            zi = i;
+        }
+    }
+
+    inline __m128d abs_pd(__m128d v)
+    {
+        return _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+    }
+
+    // Zwei Pixel pro SSE2-Register, N Register verschränkt für mehr Parallelität im Kern;
+    // gezählt wird, solange |z|^2 <= 4
+    template <Formula F, int P, int N>
+    inline void iterate(const __m128d *pr, __m128d pi, int max_iter, const FractalParams &params, int *out)
+    {
+        const __m128d four = _mm_set1_pd(4.0);
+        const __m128d one = _mm_set1_pd(1.0);
+
+        __m128d zr[N], zi[N], cr[N], ci[N], count[N], active[N];
+#pragma GCC unroll 4
+        for (int k = 0; k < N; ++k)
+        {
+            if constexpr (F == Formula::Julia)
+            {
+                zr[k] = pr[k];
+                zi[k] = pi;
+                cr[k] = _mm_set1_pd(params.julia_re);
+                ci[k] = _mm_set1_pd(params.julia_im);
+            }
+            else
+            {
+                zr[k] = _mm_setzero_pd();
+                zi[k] = _mm_setzero_pd();
+                cr[k] = pr[k];
+                ci[k] = pi;
+            }
+            count[k] = _mm_setzero_pd();
+            active[k] = _mm_castsi128_pd(_mm_set1_epi32(-1));
+        }
+
+        for (int n = 0; n < max_iter; ++n)
+        {
+            __m128d r2[N], i2[N];
+            __m128d any = _mm_setzero_pd();
+#pragma GCC unroll 4
+            for (int k = 0; k < N; ++k)
+            {
+                r2[k] = _mm_mul_pd(zr[k], zr[k]);
+                i2[k] = _mm_mul_pd(zi[k], zi[k]);
+                active[k] = _mm_and_pd(active[k], _mm_cmple_pd(_mm_add_pd(r2[k], i2[k]), four));
+                any = _mm_or_pd(any, active[k]);
+            }
+            if (_mm_movemask_pd(any) == 0)
+                break;
+
+#pragma GCC unroll 4
+            for (int k = 0; k < N; ++k)
+            {
+                count[k] = _mm_add_pd(count[k], _mm_and_pd(active[k], one));
+
+                if constexpr (F == Formula::BurningShip)
+                {
+                    zr[k] = abs_pd(zr[k]);
+                    zi[k] = abs_pd(zi[k]);
+                }
+
+                if constexpr (P == 2)
+                {
+                    // Quadrate aus dem Escape-Test wiederverwenden
+                    __m128d ri = _mm_mul_pd(zr[k], zi[k]);
+                    zi[k] = _mm_add_pd(_mm_add_pd(ri, ri), ci[k]);
+                    zr[k] = _mm_add_pd(_mm_sub_pd(r2[k], i2[k]), cr[k]);
+                }
+                else
+                {
+                    complex_pow<P>(zr[k], zi[k]);
+                    zr[k] = _mm_add_pd(zr[k], cr[k]);
+                    zi[k] = _mm_add_pd(zi[k], ci[k]);
+                }
+            }
+        }
+
+        for (int k = 0; k < N; ++k)
+        {
+            out[2 * k] = _mm_cvtsd_si32(count[k]);
+            out[2 * k + 1] = _mm_cvtsd_si32(_mm_unpackhi_pd(count[k], count[k]));
+        }
+    }
+
+    template <Formula F, int P, int N>
+    void row(double x0, double dx, double y, int width, int max_iter, const FractalParams &params, int *out)
+    {
+        constexpr int STEP = 2 * N;
+        const __m128d pi = _mm_set1_pd(y);
+        __m128d pr[N];
+        int x = 0;
+        for (; x + STEP <= width; x += STEP)
+        {
+            for (int k = 0; k < N; ++k)
+                pr[k] = _mm_set_pd(x0 + (x + 2 * k + 1) * dx, x0 + (x + 2 * k) * dx);
+            iterate<F, P, N>(pr, pi, max_iter, params, out + x);
+        }
+        if (x < width)
+        {
+            // Rest mit dem letzten Pixel auffüllen
+            int tail[STEP];
+            for (int k = 0; k < N; ++k)
+                pr[k] = _mm_set_pd(x0 + std::min(x + 2 * k + 1, width - 1) * dx, x0 + std::min(x + 2 * k, width - 1) * dx);
+            iterate<F, P, N>(pr, pi, max_iter, params, tail);
+            for (int i = 0; x + i < width; ++i)
+                out[x + i] = tail[i];
+        }
+    }
+
+    // Skalare Referenz ohne SIMD, gleiche Zählweise
+    template <int P>
+    inline void complex_pow(double &zr, double &zi)
+    {
+        if constexpr (P % 2 == 0)
+        {
+            complex_pow<P / 2>(zr, zi);
+            double r = zr * zr - zi * zi;
+            zi = 2.0 * zr * zi;
+            zr = r;
+        }
+        else if constexpr (P > 1)
+        {
+            double br = zr, bi = zi;
+            complex_pow<P - 1>(zr, zi);
+            double r = zr * br - zi * bi;
+            zi = zr * bi + zi * br;
+            zr = r;
+        }
+    }
+
+    template <Formula F, int P>
+    inline int iterate_scalar(double px, double py, int max_iter, const FractalParams &params)
+    {
+        double zr = 0.0, zi = 0.0, cr = px, ci = py;
+        if constexpr (F == Formula::Julia)
+        {
+            zr = px;
+            zi = py;
+            cr = params.julia_re;
+            ci = params.julia_im;
+        }
+
+        for (int n = 0; n < max_iter; ++n)
+        {
+            if (zr * zr + zi * zi > 4.0)
+                return n;
+            if constexpr (F == Formula::BurningShip)
+            {
+                zr = std::fabs(zr);
+                zi = std::fabs(zi);
+            }
+            complex_pow<P>(zr, zi);
+            zr += cr;
+            zi += ci;
+        }
+        return max_iter;
+    }
+
+    template <Formula F, int P>
+    void row_scalar(double x0, double dx, double y, int width, int max_iter, const FractalParams &params, int *out)
+    {
+        for (int x = 0; x < width; ++x)
+            out[x] = iterate_scalar<F, P>(x0 + x * dx, y, max_iter, params);
+    }
+
+    // Wie iterate, zusätzlich dz/dc (Julia: dz/dz0). Entkommene Lanes werden eingefroren,
+    // out erhält 0.5 * |z| * ln|z| / |dz| bzw. 0 für Punkte ohne Escape
+    template <Formula F, int P>
+    inline void iterate_de(__m128d pr, __m128d pi, int max_iter, const FractalParams &params, double *out)
+    {
+        const __m128d bailout = _mm_set1_pd(DE_BAILOUT * DE_BAILOUT);
+        const __m128d d = _mm_set1_pd(static_cast<double>(P));
+
+        __m128d zr, zi, cr, ci, dr, di, dc;
+        if constexpr (F == Formula::Julia)
+        {
+            zr = pr;
+            zi = pi;
+            cr = _mm_set1_pd(params.julia_re);
+            ci = _mm_set1_pd(params.julia_im);
+            dr = _mm_set1_pd(1.0);
+            dc = _mm_setzero_pd();
+        }
+        else
+        {
+            zr = _mm_setzero_pd();
+            zi = _mm_setzero_pd();
+            cr = pr;
+            ci = pi;
+            dr = _mm_setzero_pd();
+            dc = _mm_set1_pd(1.0);
+        }
+        di = _mm_setzero_pd();
+        __m128d active = _mm_castsi128_pd(_mm_set1_epi32(-1));
+
+        for (int n = 0; n < max_iter; ++n)
+        {
+            __m128d r2 = _mm_add_pd(_mm_mul_pd(zr, zr), _mm_mul_pd(zi, zi));
+            active = _mm_and_pd(active, _mm_cmple_pd(r2, bailout));
+            if (_mm_movemask_pd(active) == 0)
+                break;
+
+            // dz' = P * z^(P-1) * dz (+ 1), z' = z^(P-1) * z + c
+            __m128d pr1 = zr, pi1 = zi;
+            complex_pow<P - 1>(pr1, pi1);
+            __m128d tr = _mm_mul_pd(d, _mm_sub_pd(_mm_mul_pd(pr1, dr), _mm_mul_pd(pi1, di)));
+            __m128d ti = _mm_mul_pd(d, _mm_add_pd(_mm_mul_pd(pr1, di), _mm_mul_pd(pi1, dr)));
+            __m128d nr = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(pr1, zr), _mm_mul_pd(pi1, zi)), cr);
+            __m128d ni = _mm_add_pd(_mm_add_pd(_mm_mul_pd(pr1, zi), _mm_mul_pd(pi1, zr)), ci);
+
+            dr = _mm_or_pd(_mm_and_pd(active, _mm_add_pd(tr, dc)), _mm_andnot_pd(active, dr));
+            di = _mm_or_pd(_mm_and_pd(active, ti), _mm_andnot_pd(active, di));
+            zr = _mm_or_pd(_mm_and_pd(active, nr), _mm_andnot_pd(active, zr));
+            zi = _mm_or_pd(_mm_and_pd(active, ni), _mm_andnot_pd(active, zi));
+        }
+
+        alignas(16) double z2[2], d2[2];
+        _mm_store_pd(z2, _mm_add_pd(_mm_mul_pd(zr, zr), _mm_mul_pd(zi, zi)));
+        _mm_store_pd(d2, _mm_add_pd(_mm_mul_pd(dr, dr), _mm_mul_pd(di, di)));
+        int inside = _mm_movemask_pd(active);
+        for (int k = 0; k < 2; ++k)
+        {
+            bool escaped = !(inside & (1 << k)) && z2[k] > DE_BAILOUT * DE_BAILOUT;
+            out[k] = escaped ? 0.25 * std::sqrt(z2[k] / d2[k]) * std::log(z2[k]) : 0.0;
+        }
+    }
+
+    template <Formula F, int P>
+    void points_de(const double *re, const double *im, int count, int max_iter, const FractalParams &params, double *out)
+    {
+        int i = 0;
+        for (; i + 2 <= count; i += 2)
+            iterate_de<F, P>(_mm_loadu_pd(re + i), _mm_loadu_pd(im + i), max_iter, params, out + i);
+        if (i < count)
+        {
+            double tail[2];
+            iterate_de<F, P>(_mm_set1_pd(re[i]), _mm_set1_pd(im[i]), max_iter, params, tail);
+            out[i] = tail[0];
+        }
+    }
+}
+
+#endif // KERNEL_HPP
@@ -2,11 +2,17 @@
 #define MANDELBROT_HPP
 
 #include <opencv2/opencv.hpp>
+#include "encoder.hpp"
+#include "kernel.hpp"
+#include "tile_cache.hpp"
 
-inline int mandelbrot(double cr, double ci, int max_iter);
-void compute_chunk(int y_start, int y_end, int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, cv::Mat &image, int chunk_idx, int num_chunks, bool silent);
-void generate_mandelbrot_chunked(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, bool silent);
-void generate_mandelbrot_limited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string out_dir, bool silent);
-void generate_mandelbrot_intervall(int width, int height, int x_min, int x_max, int y_min, int y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string out_path, bool silent, int offset);
+// Aktiviert den Kachel-Cache für alle folgenden Renderings (nullptr = aus)
+void set_tile_cache(TileCache *cache);
+void colorize_row(const int *iterations, int width, int max_iter, uchar *rowPtr);
+void compute_chunk(int y_start, int y_end, int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, cv::Mat &image, int chunk_idx, int num_chunks, bool silent, const FractalParams &fractal, RowKernel kernel);
+void generate_mandelbrot_chunked(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, bool silent, const EncoderOptions &encoder_options, const FractalParams &fractal);
+void generate_mandelbrot_limited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string out_dir, bool silent, const EncoderOptions &encoder_options, const FractalParams &fractal);
+void generate_mandelbrot_intervall(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string out_path, bool silent, int offset, const EncoderOptions &encoder_options, const FractalParams &fractal);
+void generate_mandelbrot_memory(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, cv::Mat &image, bool silent, const FractalParams &fractal);
 
 #endif // MANDELBROT_HPP
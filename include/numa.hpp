@@ -0,0 +1,32 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <string>
+#include <vector>
+
+struct NumaNode
+{
+    int id;
+    std::vector<int> cpus;
+};
+
+struct NumaTopology
+{
+    std::vector<NumaNode> nodes;
+    std::vector<int> worker_cpus;  // Worker-Slot -> CPU (abwechselnd über alle Knoten verteilt)
+    std::vector<int> worker_nodes; // Worker-Slot -> Knotenindex in nodes
+};
+
+// Liest die Topologie aus /sys/devices/system/node, fällt ohne sysfs auf einen Knoten zurück
+NumaTopology detect_numa_topology();
+
+void numa_enable(bool enabled);
+const NumaTopology &numa_topology();
+int numa_node_count();
+
+// Pinnt den aufrufenden Thread auf die CPU des Worker-Slots, gibt den Knotenindex zurück
+int numa_pin_worker(int slot);
+
+void print_numa_topology(int num_workers);
+
+#endif // NUMA_HPP
@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "numa.hpp"
+
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::vector<std::queue<std::function<void()>>> tasks; // eine Warteschlange pro NUMA-Knoten
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+
+    // Eigener Knoten zuerst, sonst von anderen Knoten stehlen
+    bool pop_task(int node, std::function<void()> &task)
+    {
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            auto &queue = tasks[(node + i) % tasks.size()];
+            if (!queue.empty())
+            {
+                task = std::move(queue.front());
+                queue.pop();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool has_tasks() const
+    {
+        for (const auto &queue : tasks)
+            if (!queue.empty())
+                return true;
+        return false;
+    }
+
+public:
+    explicit ThreadPool(size_t threads) : tasks(numa_node_count()), stop(false)
+    {
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this, i]
+                                 {
+                int node = numa_pin_worker(static_cast<int>(i));
+                while(true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex);
+                        condition.wait(lock, [this] { 
+                            return stop || has_tasks(); 
+                        });
+                        if(stop && !has_tasks()) return;
+                        pop_task(node, task);
+                    }
+                    task();
+                } });
+    }
+
+    size_t node_count() const
+    {
+        return tasks.size();
+    }
+
+    template <class F>
+    auto enqueue(F &&f, int node = 0) -> std::future<typename std::invoke_result<F>::type>
+    {
+        using return_type = typename std::invoke_result<F>::type;
+        auto task = std::make_shared<std::packaged_task<return_type()>>(std::forward<F>(f));
+        std::future<return_type> res = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks[node % tasks.size()].emplace([task]()
+                                               { (*task)(); });
+        }
+        condition.notify_one();
+        return res;
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,109 @@
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "kernel.hpp"
+
+constexpr int TILE_SIZE = 64;
+constexpr int LEVELS_PER_OCTAVE = 8; // Zoomstufen pro Verdopplung der Pixelgröße
+
+// Quantisiertes Raster: Pixel (gx, gy) liegt bei (gx * step, gy * step)
+struct CacheGrid
+{
+    int level;
+    double step;
+    int64_t origin_x; // globaler Pixelindex der linken Bildspalte
+    int64_t origin_y; // globaler Pixelindex der oberen Bildzeile
+};
+
+double grid_step(int level);
+
+// Rastet den Ausschnitt auf das Raster ein (Pixelgröße und Ursprung), Mittelpunkt bleibt erhalten
+CacheGrid snap_viewport(int width, int height, double &x_min, double &x_max, double &y_min, double &y_max);
+CacheGrid grid_from_viewport(int width, double x_min, double x_max, double y_min);
+
+struct TileKey
+{
+    int level;
+    int64_t tx;
+    int64_t ty;
+    int max_iter;
+    uint64_t fractal; // Formel/Potenz/Julia-Konstante, damit Varianten sich nicht vermischen
+
+    bool operator==(const TileKey &other) const
+    {
+        return level == other.level && tx == other.tx && ty == other.ty &&
+               max_iter == other.max_iter && fractal == other.fractal;
+    }
+};
+
+struct TileKeyHash
+{
+    size_t operator()(const TileKey &k) const;
+};
+
+uint64_t fractal_signature(const FractalParams &params);
+
+using TileData = std::vector<int>; // TILE_SIZE * TILE_SIZE Iterationswerte, zeilenweise
+
+// Iterations-Cache mit LRU im Speicher und Auslagerung auf die Platte
+class TileCache
+{
+private:
+    struct Entry
+    {
+        std::shared_ptr<const TileData> data;
+        bool on_disk;
+        std::list<TileKey>::iterator lru;
+    };
+
+    std::string dir;
+    size_t capacity; // maximale Anzahl Kacheln im Speicher
+    std::mutex mtx;
+    std::list<TileKey> lru; // vorne = zuletzt benutzt
+    std::unordered_map<TileKey, Entry, TileKeyHash> tiles;
+    // Kacheln, die gerade berechnet werden; weitere Anfragen warten auf dasselbe Ergebnis
+    std::unordered_map<TileKey, std::shared_future<std::shared_ptr<const TileData>>, TileKeyHash> in_flight;
+    // Verdrängte Kacheln, deren Auslagerung noch läuft; get() findet sie weiterhin
+    std::unordered_map<TileKey, std::shared_ptr<const TileData>, TileKeyHash> spilling;
+
+    std::atomic<uint64_t> memory_hits{0};
+    std::atomic<uint64_t> disk_hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> joined{0};
+    std::atomic<uint64_t> spilled{0};
+
+    std::string tile_path(const TileKey &key) const;
+    bool write_tile(const TileKey &key, const TileData &data);
+    std::shared_ptr<const TileData> read_tile(const TileKey &key);
+    using SpillList = std::vector<std::pair<TileKey, std::shared_ptr<const TileData>>>;
+
+    // Unter der Sperre nur Verwaltung, geschrieben wird danach über spill()
+    void insert_locked(const TileKey &key, std::shared_ptr<const TileData> data, bool on_disk, SpillList &victims);
+    void evict_locked(SpillList &victims);
+    void spill(const SpillList &victims);
+
+public:
+    TileCache(const std::string &dir, size_t memory_mb);
+    ~TileCache();
+
+    // nullptr bei Fehlschlag (weder im Speicher noch auf der Platte)
+    std::shared_ptr<const TileData> get(const TileKey &key);
+    // Wie get, bei Fehlschlag berechnet genau ein Aufrufer die Kachel über compute und legt sie ab
+    std::shared_ptr<const TileData> get_or_compute(const TileKey &key, const std::function<std::shared_ptr<const TileData>()> &compute);
+
+    // Schreibt alle nur im Speicher liegenden Kacheln auf die Platte
+    void flush();
+    void print_stats();
+};
+
+#endif // TILE_CACHE_HPP
@@ -0,0 +1,22 @@
+#ifndef TUNE_HPP
+#define TUNE_HPP
+
+#include <string>
+#include "kernel.hpp"
+
+struct HostProfile
+{
+    int num_workers = 3;
+    int chunk_size = 100;
+    KernelVariant kernel = KernelVariant::SSE2;
+};
+
+// ~/.config/mandelbrot/<hostname>.conf (bzw. $XDG_CONFIG_HOME)
+std::string host_profile_path();
+bool load_host_profile(const std::string &path, HostProfile &profile);
+bool save_host_profile(const std::string &path, const HostProfile &profile);
+
+// Kurze Kalibrierung: Kernel-Variante, Worker-Anzahl und Chunk-Größe nacheinander durchprobieren
+HostProfile tune_host(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, const FractalParams &fractal, const HostProfile &start);
+
+#endif // TUNE_HPP
@@ -33,10 +33,15 @@ def process_host(host, local_file, remote_folder, local_results_folder, interval
         remote_file = f"{remote_folder}/mandelbrot"
         copy_file_to_remote(ssh, local_file, remote_file)
 
-        # Führe das C++ Programm mit festen und dynamischen Argumenten aus
+        # Einmalige Kalibrierung pro Host; Worker-Anzahl und Kernel kommen danach aus dem Host-Profil.
+        # Die Chunk-Größe bleibt fest, damit die Chunk-Indizes auf allen Hosts zusammenpassen.
+        # Das Profil liegt neben dem Zielordner, damit es nicht mit den Ergebnissen zurückkopiert wird.
+        profile_path = f"{remote_folder}.conf"
         command = (
-            f"chmod +x {remote_file} && {remote_file} -w 8000 -h 6000 --chunk_size 100 "
-            f"--num_workers --interval {interval} --offset {offset}"
+            f"chmod +x {remote_file} && "
+            f"(test -f {profile_path} || {remote_file} --tune --profile {profile_path} -w 8000 -h 6000) && "
+            f"cd {remote_folder} && {remote_file} --profile {profile_path} -w 8000 -h 6000 --chunk_size 100 "
+            f"--intervall {interval} --offset {offset}"
         )
         stdout, stderr, status = execute_remote_command(ssh, command)
 
@@ -0,0 +1,447 @@
+#include "async_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <tuple>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "numa.hpp"
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+
+// Seitenausgerichtete Puffer, gemeinsam für beide Backends
+class BufferSet
+{
+private:
+    std::vector<uint8_t *> buffers;
+    std::vector<int> nodes; // Knotenindex je Platz, wie ThreadPool-Worker mit gleichem Index
+    size_t size;
+
+public:
+    BufferSet(int count, size_t size) : size(size)
+    {
+        size_t aligned = (std::max<size_t>(size, 1) + 4095) & ~size_t(4095);
+        for (int i = 0; i < count; ++i)
+        {
+            void *ptr = std::aligned_alloc(4096, aligned);
+            if (!ptr)
+                throw std::bad_alloc();
+            buffers.push_back(static_cast<uint8_t *>(ptr));
+        }
+
+        // First Touch von einem Thread auf dem Knoten des Platzes, bevor io_uring die Seiten registriert
+        nodes.assign(count, 0);
+        if (numa_node_count() > 1)
+        {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < count; ++i)
+                threads.emplace_back([this, i, aligned]
+                                     {
+                                         nodes[i] = numa_pin_worker(i);
+                                         std::memset(buffers[i], 0, aligned); });
+            for (auto &t : threads)
+                t.join();
+        }
+    }
+
+    ~BufferSet()
+    {
+        for (uint8_t *ptr : buffers)
+            std::free(ptr);
+    }
+
+    uint8_t *get(int slot) { return buffers[slot]; }
+    int node(int slot) const { return nodes[slot]; }
+    size_t buffer_size() const { return size; }
+    int count() const { return static_cast<int>(buffers.size()); }
+};
+
+// ---------------------------------------------------------------------------
+// Rückfall: pread/pwrite auf eigenen Threads
+// ---------------------------------------------------------------------------
+
+class ThreadedIO : public AsyncIO
+{
+private:
+    struct Request
+    {
+        bool write;
+        int fd;
+        int slot;
+        size_t len;
+        off_t offset;
+        uint64_t tag;
+    };
+
+    BufferSet buffers;
+    std::vector<std::thread> workers;
+    std::deque<Request> requests;
+    std::deque<std::pair<uint64_t, int>> completions;
+    std::mutex mtx;
+    std::condition_variable request_cv, completion_cv;
+    int pending = 0;
+    bool stop = false;
+
+    int execute(const Request &req)
+    {
+        uint8_t *data = buffers.get(req.slot);
+        size_t done = 0;
+        while (done < req.len)
+        {
+            ssize_t n = req.write ? pwrite(req.fd, data + done, req.len - done, req.offset + done)
+                                  : pread(req.fd, data + done, req.len - done, req.offset + done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return -errno;
+            if (n == 0)
+                break;
+            done += n;
+        }
+        return static_cast<int>(done);
+    }
+
+    bool submit(const Request &req)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            requests.push_back(req);
+            pending++;
+        }
+        request_cv.notify_one();
+        return true;
+    }
+
+public:
+    ThreadedIO(int depth, size_t buffer_size) : buffers(depth, buffer_size)
+    {
+        int count = std::min(depth, 16);
+        for (int i = 0; i < count; ++i)
+            workers.emplace_back([this]
+                                 {
+                while (true) {
+                    Request req;
+                    {
+                        std::unique_lock<std::mutex> lock(mtx);
+                        request_cv.wait(lock, [this] { return stop || !requests.empty(); });
+                        if (stop && requests.empty()) return;
+                        req = requests.front();
+                        requests.pop_front();
+                    }
+                    int result = execute(req);
+                    {
+                        std::lock_guard<std::mutex> lock(mtx);
+                        completions.emplace_back(req.tag, result);
+                    }
+                    completion_cv.notify_one();
+                } });
+    }
+
+    ~ThreadedIO() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        request_cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    const char *name() const override { return "threads"; }
+    int depth() const override { return buffers.count(); }
+    size_t buffer_size() const override { return buffers.buffer_size(); }
+    uint8_t *buffer(int slot) override { return buffers.get(slot); }
+    int buffer_node(int slot) const override { return buffers.node(slot); }
+
+    bool submit_read(int fd, int slot, size_t len, off_t offset, uint64_t tag) override
+    {
+        return submit({false, fd, slot, len, offset, tag});
+    }
+
+    bool submit_write(int fd, int slot, size_t len, off_t offset, uint64_t tag) override
+    {
+        return submit({true, fd, slot, len, offset, tag});
+    }
+
+    bool wait(uint64_t &tag, int &result) override
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (pending == 0)
+            return false;
+        completion_cv.wait(lock, [this] { return !completions.empty(); });
+        std::tie(tag, result) = completions.front();
+        completions.pop_front();
+        pending--;
+        return true;
+    }
+
+    bool poll(uint64_t &tag, int &result) override
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (completions.empty())
+            return false;
+        std::tie(tag, result) = completions.front();
+        completions.pop_front();
+        pending--;
+        return true;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// io_uring über die rohen Syscalls (keine liburing-Abhängigkeit)
+// ---------------------------------------------------------------------------
+
+#ifdef HAVE_IO_URING
+
+class UringIO : public AsyncIO
+{
+private:
+    // Ein Auftrag pro Platz; kurze Transfers werden mit dem Rest erneut eingereiht
+    struct Request
+    {
+        uint8_t opcode;
+        int fd;
+        size_t len;
+        off_t offset;
+        size_t done;
+        uint64_t tag;
+    };
+
+    BufferSet buffers;
+    std::vector<iovec> iovecs; // je Platz, für READV/WRITEV ohne registrierte Puffer
+    std::vector<Request> requests;
+    bool fixed_buffers = false;
+    int pending = 0;
+
+    int ring_fd = -1;
+    void *sq_ptr = MAP_FAILED, *cq_ptr = MAP_FAILED;
+    size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    unsigned *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+    unsigned *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    static int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    bool submit(int slot)
+    {
+        const Request &req = requests[slot];
+        uint8_t *data = buffers.get(slot) + req.done;
+        size_t len = req.len - req.done;
+
+        unsigned tail = *sq_tail;
+        unsigned idx = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+
+        sqe->fd = req.fd;
+        sqe->off = static_cast<uint64_t>(req.offset + req.done);
+        sqe->user_data = static_cast<uint64_t>(slot);
+        if (fixed_buffers)
+        {
+            sqe->opcode = req.opcode == IORING_OP_WRITEV ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(data);
+            sqe->len = static_cast<uint32_t>(len);
+            sqe->buf_index = static_cast<uint16_t>(slot);
+        }
+        else
+        {
+            iovecs[slot] = {data, len};
+            sqe->opcode = req.opcode;
+            sqe->addr = reinterpret_cast<uint64_t>(&iovecs[slot]);
+            sqe->len = 1;
+        }
+
+        sq_array[idx] = idx;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        int ret;
+        do
+        {
+            ret = enter(ring_fd, 1, 0, 0);
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0)
+        {
+            // Eintrag zurücknehmen, der Kernel hat ihn nicht übernommen
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+        return true;
+    }
+
+    bool start(uint8_t opcode, int fd, int slot, size_t len, off_t offset, uint64_t tag)
+    {
+        requests[slot] = {opcode, fd, len, offset, 0, tag};
+        if (!submit(slot))
+            return false;
+        pending++;
+        return true;
+    }
+
+    // Liefert nur vollständige (oder endgültig gescheiterte) Aufträge, wie ThreadedIO::execute
+    bool reap(uint64_t &tag, int &result)
+    {
+        while (true)
+        {
+            unsigned head = *cq_head;
+            if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+                return false;
+            const io_uring_cqe &cqe = cqes[head & *cq_mask];
+            int slot = static_cast<int>(cqe.user_data);
+            int res = cqe.res;
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+            Request &req = requests[slot];
+            if (res > 0)
+                req.done += static_cast<size_t>(res);
+            bool retry = res == -EINTR || res == -EAGAIN || (res > 0 && req.done < req.len);
+            if (retry && submit(slot))
+                continue;
+
+            tag = req.tag;
+            result = res < 0 ? res : static_cast<int>(req.done);
+            pending--;
+            return true;
+        }
+    }
+
+public:
+    UringIO(int depth, size_t buffer_size) : buffers(depth, buffer_size), iovecs(depth), requests(depth) {}
+
+    ~UringIO() override
+    {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqes_size);
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+            munmap(cq_ptr, cq_size);
+        if (sq_ptr != MAP_FAILED)
+            munmap(sq_ptr, sq_size);
+        if (ring_fd >= 0)
+            close(ring_fd);
+    }
+
+    bool init()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, buffers.count(), &params));
+        if (ring_fd < 0)
+            return false;
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+            sq_size = cq_size = std::max(sq_size, cq_size);
+
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED)
+            return false;
+        cq_ptr = single_mmap ? sq_ptr : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED)
+            return false;
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+            return false;
+
+        auto *sq = static_cast<uint8_t *>(sq_ptr);
+        auto *cq = static_cast<uint8_t *>(cq_ptr);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // Registrierte Puffer sparen das Pinnen pro Auftrag; scheitert u.a. an RLIMIT_MEMLOCK
+        std::vector<iovec> regs(buffers.count());
+        for (int i = 0; i < buffers.count(); ++i)
+            regs[i] = {buffers.get(i), buffers.buffer_size()};
+        fixed_buffers = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, regs.data(), regs.size()) == 0;
+        return true;
+    }
+
+    const char *name() const override { return fixed_buffers ? "io_uring (registrierte Puffer)" : "io_uring"; }
+    int depth() const override { return buffers.count(); }
+    size_t buffer_size() const override { return buffers.buffer_size(); }
+    uint8_t *buffer(int slot) override { return buffers.get(slot); }
+    int buffer_node(int slot) const override { return buffers.node(slot); }
+
+    bool submit_read(int fd, int slot, size_t len, off_t offset, uint64_t tag) override
+    {
+        return start(IORING_OP_READV, fd, slot, len, offset, tag);
+    }
+
+    bool submit_write(int fd, int slot, size_t len, off_t offset, uint64_t tag) override
+    {
+        return start(IORING_OP_WRITEV, fd, slot, len, offset, tag);
+    }
+
+    bool wait(uint64_t &tag, int &result) override
+    {
+        while (!reap(tag, result))
+        {
+            if (pending == 0)
+                return false;
+            if (enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+                return false;
+        }
+        return true;
+    }
+
+    bool poll(uint64_t &tag, int &result) override
+    {
+        return reap(tag, result);
+    }
+};
+
+#endif // HAVE_IO_URING
+
+bool is_known_io_backend(const std::string &backend)
+{
+    return backend == "auto" || backend == "uring" || backend == "threads";
+}
+
+std::unique_ptr<AsyncIO> create_async_io(const AsyncIOOptions &options, size_t buffer_size)
+{
+    // Alle Plätze zusammen bleiben im Speicherbudget (registrierte Puffer sind gepinnt)
+    size_t budget = static_cast<size_t>(std::max(1, options.buffer_mb)) << 20;
+    int depth = std::max(1, options.queue_depth);
+    size_t fit = budget / std::max<size_t>(buffer_size, 1);
+    if (fit < static_cast<size_t>(depth))
+    {
+        depth = static_cast<int>(std::max<size_t>(fit, 1));
+        std::cerr << "Hinweis: I/O-Tiefe auf " << depth << " begrenzt (" << options.buffer_mb << " MB Puffer)." << std::endl;
+    }
+
+#ifdef HAVE_IO_URING
+    if (options.backend != "threads")
+    {
+        auto uring = std::make_unique<UringIO>(depth, buffer_size);
+        if (uring->init())
+            return uring;
+        if (options.backend == "uring")
+            std::cerr << "Warnung: io_uring nicht verfügbar, verwende Thread-Pool." << std::endl;
+    }
+#endif
+
+    return std::make_unique<ThreadedIO>(depth, buffer_size);
+}
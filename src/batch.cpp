@@ -0,0 +1,352 @@
+#include "batch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include "mandelbrot.hpp"
+#include "progress.hpp"
+#include "thread_pool.hpp"
+#include "tile_cache.hpp"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+// Minimaler Parser für flache JSON-Objekte: {"key": 1.5, "name": "text"}
+static bool parse_flat_json(const std::string &line, std::map<std::string, std::string> &fields, std::string &error)
+{
+    size_t p = 0;
+    auto skip_ws = [&]
+    {
+        while (p < line.size() && std::isspace(static_cast<unsigned char>(line[p])))
+            p++;
+    };
+    auto parse_string = [&](std::string &out)
+    {
+        if (p >= line.size() || line[p] != '"')
+            return false;
+        p++;
+        out.clear();
+        while (p < line.size() && line[p] != '"')
+        {
+            char c = line[p++];
+            if (c == '\\' && p < line.size())
+            {
+                char e = line[p++];
+                switch (e)
+                {
+                case 'n':
+                    c = '\n';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                default:
+                    c = e; // \" \\ \/
+                    break;
+                }
+            }
+            out += c;
+        }
+        if (p >= line.size())
+            return false;
+        p++;
+        return true;
+    };
+
+    skip_ws();
+    if (p >= line.size() || line[p++] != '{')
+    {
+        error = "'{' erwartet";
+        return false;
+    }
+    skip_ws();
+    if (p < line.size() && line[p] == '}')
+        return true;
+
+    while (true)
+    {
+        std::string key, value;
+        skip_ws();
+        if (!parse_string(key))
+        {
+            error = "Schlüssel erwartet";
+            return false;
+        }
+        skip_ws();
+        if (p >= line.size() || line[p++] != ':')
+        {
+            error = "':' nach \"" + key + "\" erwartet";
+            return false;
+        }
+        skip_ws();
+        if (p < line.size() && line[p] == '"')
+        {
+            if (!parse_string(value))
+            {
+                error = "Unvollständige Zeichenkette bei \"" + key + "\"";
+                return false;
+            }
+        }
+        else
+        {
+            size_t start = p;
+            while (p < line.size() && line[p] != ',' && line[p] != '}' && !std::isspace(static_cast<unsigned char>(line[p])))
+                p++;
+            value = line.substr(start, p - start);
+        }
+        fields[key] = value;
+
+        skip_ws();
+        if (p < line.size() && line[p] == ',')
+        {
+            p++;
+            continue;
+        }
+        if (p < line.size() && line[p] == '}')
+            return true;
+        error = "',' oder '}' erwartet";
+        return false;
+    }
+}
+
+std::vector<BatchJob> load_batch_jobs(const std::string &path, const BatchJob &defaults)
+{
+    std::vector<BatchJob> jobs;
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Fehler: Konnte Auftragsdatei nicht öffnen: " << path << std::endl;
+        return jobs;
+    }
+
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line))
+    {
+        line_no++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::map<std::string, std::string> fields;
+        std::string error;
+        BatchJob job = defaults;
+        try
+        {
+            if (!parse_flat_json(line, fields, error))
+                throw std::runtime_error(error);
+
+            for (const auto &[key, value] : fields)
+            {
+                if (key == "x_min")
+                    job.x_min = std::stod(value);
+                else if (key == "x_max")
+                    job.x_max = std::stod(value);
+                else if (key == "y_min")
+                    job.y_min = std::stod(value);
+                else if (key == "y_max")
+                    job.y_max = std::stod(value);
+                else if (key == "width")
+                    job.width = std::stoi(value);
+                else if (key == "height")
+                    job.height = std::stoi(value);
+                else if (key == "max_iter")
+                    job.max_iter = std::stoi(value);
+                else if (key == "output")
+                    job.output = value;
+                else
+                    std::cerr << "Warnung: Zeile " << line_no << ": unbekanntes Feld \"" << key << "\"" << std::endl;
+            }
+            if (job.width <= 0 || job.height <= 0 || job.max_iter <= 0 || job.output.empty())
+                throw std::runtime_error("width, height, max_iter und output müssen gesetzt sein");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Fehler: " << path << ":" << line_no << ": " << e.what() << " - Auftrag übersprungen" << std::endl;
+            continue;
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+// CSV-Feld nach RFC 4180: in Anführungszeichen, eingebettete '"' verdoppelt
+static std::string csv_quote(const std::string &field)
+{
+    std::string out = "\"";
+    for (char c : field)
+    {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+bool run_batch(std::vector<BatchJob> jobs, int chunk_size, int num_workers, const EncoderOptions &encoder_options,
+               const FractalParams &fractal, const std::string &report_path, bool snap_to_grid)
+{
+    struct JobState
+    {
+        int tiles = 0;
+        std::atomic<int> remaining{0};
+        std::once_flag allocated;
+        cv::Mat image;
+        std::atomic<int64_t> compute_ns{0};
+        std::atomic<int64_t> first_start_ns{-1};
+        int64_t done_ns = 0;
+        double encode_s = 0.0;
+        bool ok = false;
+    };
+
+    if (jobs.empty())
+    {
+        std::cerr << "Fehler: Keine gültigen Aufträge." << std::endl;
+        return false;
+    }
+
+    // Format folgt der Dateiendung des Auftrags, sonst --format
+    auto job_encoder = [&encoder_options](const BatchJob &job)
+    {
+        EncoderOptions options = encoder_options;
+        std::string ext = fs::path(job.output).extension().string();
+        if (ext.size() > 1 && is_known_format(ext.substr(1)))
+            options.format = ext.substr(1);
+        return options;
+    };
+
+    RowKernel kernel = select_kernel(fractal);
+    std::vector<std::unique_ptr<JobState>> states;
+    std::set<fs::path> dirs;
+    int total_tiles = 0;
+
+    for (auto &job : jobs)
+    {
+        if (snap_to_grid)
+            snap_viewport(job.width, job.height, job.x_min, job.x_max, job.y_min, job.y_max);
+
+        auto state = std::make_unique<JobState>();
+        state->tiles = (job.height + chunk_size - 1) / chunk_size;
+        state->remaining = state->tiles;
+        total_tiles += state->tiles;
+        states.push_back(std::move(state));
+
+        fs::path dir = fs::path(job.output).parent_path();
+        if (!dir.empty())
+            dirs.insert(dir);
+    }
+
+    // Verzeichnisse nur einmal pro Lauf anlegen
+    for (const auto &dir : dirs)
+        fs::create_directories(dir);
+
+    // Teuerste Aufträge zuerst, kleine füllen am Ende die Lücken
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     {
+                         double cost_a = double(jobs[a].width) * jobs[a].height * jobs[a].max_iter;
+                         double cost_b = double(jobs[b].width) * jobs[b].height * jobs[b].max_iter;
+                         return cost_a > cost_b; });
+
+    std::cout << "Batch: " << jobs.size() << " Aufträge, " << total_tiles << " Kacheln, "
+              << num_workers << " Worker" << std::endl;
+
+    ProgressBar progress(total_tiles, "Batch");
+    std::mutex progress_mutex;
+    const auto batch_start = Clock::now();
+    auto since_start = [&batch_start]
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - batch_start).count();
+    };
+
+    {
+        ThreadPool pool(num_workers);
+
+        for (size_t j : order)
+        {
+            const BatchJob &job = jobs[j];
+            JobState &state = *states[j];
+
+            for (int tile = 0; tile < state.tiles; ++tile)
+            {
+                pool.enqueue([&, tile]()
+                             {
+                                 int y_start = tile * chunk_size;
+                                 int y_end = std::min(y_start + chunk_size, job.height);
+
+                                 int64_t start = since_start();
+                                 int64_t unset = -1;
+                                 state.first_start_ns.compare_exchange_strong(unset, start);
+
+                                 // Bildpuffer erst beim ersten Kachelstart anlegen (First Touch auf dem Worker-Knoten)
+                                 std::call_once(state.allocated, [&]
+                                                { state.image.create(job.height, job.width, CV_8UC3); });
+
+                                 cv::Mat rows = state.image.rowRange(y_start, y_end);
+                                 compute_chunk(y_start, y_end, job.width, job.height, job.x_min, job.x_max, job.y_min, job.y_max,
+                                               job.max_iter, rows, tile, state.tiles, true, fractal, kernel);
+                                 state.compute_ns += since_start() - start;
+
+                                 {
+                                     std::lock_guard<std::mutex> lock(progress_mutex);
+                                     progress.increment();
+                                 }
+
+                                 // Die letzte Kachel eines Auftrags schreibt das Bild
+                                 if (--state.remaining == 0)
+                                 {
+                                     auto t0 = Clock::now();
+                                     state.ok = create_encoder(job_encoder(job))->write(job.output, state.image);
+                                     state.encode_s = std::chrono::duration<double>(Clock::now() - t0).count();
+                                     state.image.release();
+                                     state.done_ns = since_start();
+                                     if (!state.ok)
+                                         std::cerr << "\nFehler: Konnte " << job.output << " nicht schreiben." << std::endl;
+                                 } },
+                             static_cast<int>(j % pool.node_count()));
+            }
+        }
+    }
+
+    double batch_s = since_start() / 1e9;
+    std::cout << std::endl;
+
+    std::ofstream report(report_path);
+    if (!report)
+        std::cerr << "Fehler: Konnte Bericht nicht schreiben: " << report_path << std::endl;
+    report << "job,output,width,height,max_iter,tiles,wait_s,compute_s,encode_s,wall_s,ok\n";
+
+    int failed = 0;
+    double compute_total = 0.0;
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        const BatchJob &job = jobs[j];
+        const JobState &state = *states[j];
+        double wait_s = state.first_start_ns / 1e9;
+        double compute_s = state.compute_ns / 1e9;
+        double wall_s = (state.done_ns - state.first_start_ns) / 1e9;
+        compute_total += compute_s;
+        failed += state.ok ? 0 : 1;
+
+        report << j << "," << csv_quote(job.output) << "," << job.width << "," << job.height << "," << job.max_iter << ","
+               << state.tiles << "," << std::fixed << std::setprecision(4) << wait_s << "," << compute_s << ","
+               << state.encode_s << "," << wall_s << "," << (state.ok ? 1 : 0) << "\n";
+    }
+
+    std::cout << "Batch abgeschlossen: " << (jobs.size() - failed) << "/" << jobs.size() << " Bilder in "
+              << std::fixed << std::setprecision(2) << batch_s << " s (Auslastung "
+              << std::setprecision(1) << 100.0 * compute_total / (batch_s * num_workers) << "%)" << std::endl;
+    std::cout << "Zeitbericht: " << report_path << std::endl;
+    return failed == 0;
+}
@@ -0,0 +1,451 @@
+#include "buddhabrot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "mandelbrot.hpp"
+#include "numa.hpp"
+#include "progress.hpp"
+
+namespace fs = std::filesystem;
+
+// Histogramm in 32x32-Blöcken (4 KiB): benachbarte Orbitpunkte landen meist im selben Block
+constexpr int HIST_BLOCK = 32;
+constexpr int SAMPLE_BATCH = 1 << 16;       // Samples pro Fortschrittsschritt
+constexpr int IMPORTANCE_GRID = 256;        // Zellen pro Achse über [-2, 2]^2
+constexpr int IMPORTANCE_PROBES = 4;        // Probepunkte pro Zelle und Achse
+constexpr int IMPORTANCE_MAX_ITER = 500;    // Iterationen der Probe
+constexpr double IMPORTANCE_FLOOR = 0.02;   // Mindestgewicht, damit keine Zelle ganz wegfällt
+constexpr double SAMPLE_RADIUS = 2.0;       // |c| > 2 entkommt für alle unterstützten Formeln
+constexpr int DENSITY_LEVELS = 1000;        // Auflösung der Tonwertkurve für colorize_row
+
+struct Histogram
+{
+    int width = 0, rows = 0, blocks_x = 0;
+    std::vector<float> data;
+
+    void reset(int w, int r)
+    {
+        width = w;
+        rows = r;
+        blocks_x = (w + HIST_BLOCK - 1) / HIST_BLOCK;
+        size_t size = static_cast<size_t>(blocks_x) * ((r + HIST_BLOCK - 1) / HIST_BLOCK) * HIST_BLOCK * HIST_BLOCK;
+        if (data.size() != size)
+            data.assign(size, 0.0f);
+        else
+            std::fill(data.begin(), data.end(), 0.0f);
+    }
+
+    float &at(int x, int y)
+    {
+        size_t block = static_cast<size_t>(y / HIST_BLOCK) * blocks_x + x / HIST_BLOCK;
+        return data[block * HIST_BLOCK * HIST_BLOCK + (y % HIST_BLOCK) * HIST_BLOCK + x % HIST_BLOCK];
+    }
+};
+
+// Verteilung der c-Werte: Zelle per CDF wählen, Punkt gleichverteilt in der Zelle
+struct SamplingMap
+{
+    std::vector<double> cdf;    // leer = gleichverteilt über [-2, 2]^2
+    std::vector<float> weight;  // Korrektur 1 / (Zellen * p), hält die Dichte erwartungstreu
+};
+
+struct BandJob
+{
+    int width, height, band_start, band_end, max_iter;
+    double x_min, x_max, y_min, y_max;
+    bool anti;
+    int64_t samples;
+    uint64_t seed;
+    const FractalParams *fractal;
+    const SamplingMap *map;
+};
+
+static uint64_t splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// xorshift64*, pro Worker eigener Zustand
+struct Random
+{
+    uint64_t state;
+
+    explicit Random(uint64_t seed) : state(splitmix64(seed) | 1) {}
+
+    double next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return ((state * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+    }
+};
+
+static bool in_main_bulbs(double cr, double ci)
+{
+    double xq = cr - 0.25;
+    double q = xq * xq + ci * ci;
+    if (q * (q + xq) <= 0.25 * ci * ci)
+        return true;
+    return (cr + 1.0) * (cr + 1.0) + ci * ci <= 0.0625;
+}
+
+template <Formula F, int P>
+static void sample_band(const BandJob &job, Histogram &hist, ProgressBar *progress, std::mutex &progress_mutex)
+{
+    const double sx = job.width / (job.x_max - job.x_min);
+    const double sy = job.height / (job.y_max - job.y_min);
+    const double cell = 2.0 * SAMPLE_RADIUS / IMPORTANCE_GRID;
+    const SamplingMap &map = *job.map;
+    Random rng(job.seed);
+
+    double cr[2], ci[2];
+    float weight[2];
+    int pending = 0;
+
+    auto draw = [&](double &re, double &im, float &w)
+    {
+        if (map.cdf.empty())
+        {
+            re = -SAMPLE_RADIUS + 2.0 * SAMPLE_RADIUS * rng.next();
+            im = -SAMPLE_RADIUS + 2.0 * SAMPLE_RADIUS * rng.next();
+            w = 1.0f;
+            return;
+        }
+        size_t c = std::upper_bound(map.cdf.begin(), map.cdf.end(), rng.next() * map.cdf.back()) - map.cdf.begin();
+        c = std::min(c, map.cdf.size() - 1);
+        re = -SAMPLE_RADIUS + (c % IMPORTANCE_GRID + rng.next()) * cell;
+        im = -SAMPLE_RADIUS + (c / IMPORTANCE_GRID + rng.next()) * cell;
+        w = map.weight[c];
+    };
+
+    auto trace = [&](double re, double im, int count, float w)
+    {
+        double zr = 0.0, zi = 0.0;
+        for (int n = 0; n < count; ++n)
+        {
+            if constexpr (F == Formula::BurningShip)
+            {
+                zr = std::fabs(zr);
+                zi = std::fabs(zi);
+            }
+            kernel::complex_pow<P>(zr, zi);
+            zr += re;
+            zi += im;
+
+            double px = (zr - job.x_min) * sx;
+            double py = (zi - job.y_min) * sy;
+            if (px < 0.0 || px >= job.width || py < job.band_start || py >= job.band_end)
+                continue;
+            hist.at(static_cast<int>(px), static_cast<int>(py) - job.band_start) += w;
+        }
+    };
+
+    // Zwei c-Werte pro SSE2-Register durch den Hauptkernel filtern, nur passende Orbits nachverfolgen
+    auto flush = [&](int n)
+    {
+        __m128d pr = _mm_set_pd(cr[1], cr[0]);
+        __m128d pi = _mm_set_pd(ci[1], ci[0]);
+        int count[2];
+        kernel::iterate<F, P, 1>(&pr, pi, job.max_iter, *job.fractal, count);
+        for (int k = 0; k < n; ++k)
+        {
+            bool escaped = count[k] < job.max_iter;
+            if (escaped != job.anti)
+                trace(cr[k], ci[k], escaped ? count[k] : job.max_iter, weight[k]);
+        }
+    };
+
+    for (int64_t done = 0; done < job.samples;)
+    {
+        int64_t batch_end = std::min(done + SAMPLE_BATCH, job.samples);
+        for (; done < batch_end; ++done)
+        {
+            draw(cr[pending], ci[pending], weight[pending]);
+            // Hauptkardioide und Periode-2-Kreis entkommen nie
+            if constexpr (F == Formula::Mandelbrot && P == 2)
+            {
+                if (!job.anti && in_main_bulbs(cr[pending], ci[pending]))
+                    continue;
+            }
+            if (++pending == 2)
+            {
+                flush(2);
+                pending = 0;
+            }
+        }
+
+        if (progress)
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            progress->increment();
+        }
+    }
+    if (pending)
+    {
+        cr[1] = cr[0];
+        ci[1] = ci[0];
+        flush(pending);
+    }
+}
+
+using BandSampler = void (*)(const BandJob &, Histogram &, ProgressBar *, std::mutex &);
+
+template <Formula F, int... Ps>
+static BandSampler pick_sampler(int power, std::integer_sequence<int, Ps...>)
+{
+    static const BandSampler table[] = {&sample_band<F, Ps + KERNEL_MIN_POWER>...};
+    int idx = power - KERNEL_MIN_POWER;
+    if (idx < 0 || idx >= static_cast<int>(sizeof...(Ps)))
+        return nullptr;
+    return table[idx];
+}
+
+static BandSampler select_sampler(const FractalParams &fractal)
+{
+    using Powers = std::make_integer_sequence<int, KERNEL_MAX_POWER - KERNEL_MIN_POWER + 1>;
+    switch (fractal.formula)
+    {
+    case Formula::Mandelbrot:
+        return pick_sampler<Formula::Mandelbrot>(fractal.power, Powers{});
+    case Formula::BurningShip:
+        return pick_sampler<Formula::BurningShip>(fractal.power, Powers{});
+    default:
+        return nullptr;
+    }
+}
+
+// Grobe Probe über [-2, 2]^2 mit dem Zeilenkernel: Zellen am Rand der Menge tragen die langen Orbits
+static SamplingMap build_sampling_map(int max_iter, int num_workers, bool anti, const FractalParams &fractal)
+{
+    constexpr int N = IMPORTANCE_GRID * IMPORTANCE_PROBES + 1;
+    const int probe_iter = std::min(max_iter, IMPORTANCE_MAX_ITER);
+    const double step = 2.0 * SAMPLE_RADIUS / (N - 1);
+    RowKernel kernel = select_kernel(fractal);
+
+    std::vector<int> probes(static_cast<size_t>(N) * N);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_workers; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 numa_pin_worker(t);
+                                 for (int y = t; y < N; y += num_workers)
+                                     kernel(-SAMPLE_RADIUS, step, -SAMPLE_RADIUS + y * step, N, probe_iter, fractal, probes.data() + static_cast<size_t>(y) * N); });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    SamplingMap map;
+    map.cdf.resize(IMPORTANCE_GRID * IMPORTANCE_GRID);
+    map.weight.resize(map.cdf.size());
+    double total = 0.0;
+    for (int cy = 0; cy < IMPORTANCE_GRID; ++cy)
+    {
+        for (int cx = 0; cx < IMPORTANCE_GRID; ++cx)
+        {
+            int inside = 0, samples = 0;
+            double depth = 0.0;
+            for (int py = 0; py <= IMPORTANCE_PROBES; ++py)
+            {
+                for (int px = 0; px <= IMPORTANCE_PROBES; ++px)
+                {
+                    int n = probes[static_cast<size_t>(cy * IMPORTANCE_PROBES + py) * N + cx * IMPORTANCE_PROBES + px];
+                    inside += n >= probe_iter;
+                    depth += static_cast<double>(n) / probe_iter;
+                    samples++;
+                }
+            }
+
+            double w;
+            if (inside > 0 && inside < samples)
+                w = 1.0;
+            else if (inside == samples)
+                w = anti ? 1.0 : IMPORTANCE_FLOOR;
+            else
+                w = anti ? IMPORTANCE_FLOOR : IMPORTANCE_FLOOR + depth / samples;
+
+            total += w;
+            map.cdf[cy * IMPORTANCE_GRID + cx] = total;
+            map.weight[cy * IMPORTANCE_GRID + cx] = static_cast<float>(w);
+        }
+    }
+
+    for (auto &w : map.weight)
+        w = static_cast<float>(total / (map.weight.size() * w));
+    return map;
+}
+
+// Summiert alle Thread-Histogramme blockweise in das erste, jeder Thread besitzt einen Bereich
+static void merge_histograms(std::vector<Histogram> &hists, int num_workers)
+{
+    size_t size = hists[0].data.size();
+    size_t per_thread = (size / (HIST_BLOCK * HIST_BLOCK) + num_workers - 1) / num_workers * HIST_BLOCK * HIST_BLOCK;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_workers; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 size_t begin = std::min(size, t * per_thread);
+                                 size_t end = std::min(size, begin + per_thread);
+                                 float *dst = hists[0].data.data();
+                                 for (size_t h = 1; h < hists.size(); ++h)
+                                 {
+                                     const float *src = hists[h].data.data();
+                                     for (size_t i = begin; i < end; ++i)
+                                         dst[i] += src[i];
+                                 } });
+    }
+    for (auto &t : threads)
+        t.join();
+}
+
+bool generate_buddhabrot(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int num_workers,
+                         const FractalParams &fractal, const BuddhabrotOptions &options, const std::string &filename,
+                         const std::string &temp_dir, const EncoderOptions &encoder_options, bool silent)
+{
+    BandSampler sampler = select_sampler(fractal);
+    if (!sampler)
+    {
+        std::cerr << "Fehler: Buddhabrot wird nur für Mandelbrot/Multibrot und Burning Ship unterstützt." << std::endl;
+        return false;
+    }
+    if (options.samples <= 0 || num_workers <= 0)
+    {
+        std::cerr << "Fehler: Samples und Worker müssen größer als 0 sein." << std::endl;
+        return false;
+    }
+
+    // Bandhöhe so wählen, dass alle Thread-Histogramme in das Speicherlimit passen
+    size_t row_bytes = static_cast<size_t>((width + HIST_BLOCK - 1) / HIST_BLOCK) * HIST_BLOCK * sizeof(float);
+    size_t budget = static_cast<size_t>(std::max(1, options.memory_mb)) << 20;
+    int band_rows = static_cast<int>(budget / (row_bytes * num_workers)) / HIST_BLOCK * HIST_BLOCK;
+    band_rows = std::clamp(band_rows, HIST_BLOCK, (height + HIST_BLOCK - 1) / HIST_BLOCK * HIST_BLOCK);
+    int bands = (height + band_rows - 1) / band_rows;
+
+    std::cout << (options.anti ? "Anti-Buddhabrot: " : "Buddhabrot: ") << options.samples << " Samples, "
+              << (options.importance ? "Importance Sampling" : "gleichverteilt") << ", " << bands
+              << (bands == 1 ? " Band" : " Bänder") << std::endl;
+
+    SamplingMap map;
+    if (options.importance)
+        map = build_sampling_map(max_iter, num_workers, options.anti, fractal);
+
+    int64_t batches = 0;
+    for (int t = 0; t < num_workers; ++t)
+        batches += (options.samples / num_workers + (t < options.samples % num_workers) + SAMPLE_BATCH - 1) / SAMPLE_BATCH;
+
+    // Mehrere Bänder: Zwischenergebnis als float-Zeilen auf die Platte, erst am Ende ist das Maximum bekannt
+    fs::path spill_path = fs::path(temp_dir) / "buddhabrot.raw";
+    std::fstream spill;
+    if (bands > 1)
+    {
+        fs::create_directories(temp_dir);
+        spill.open(spill_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!spill)
+        {
+            std::cerr << "Fehler: Konnte " << spill_path << " nicht anlegen." << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<Histogram> hists(num_workers);
+    std::vector<float> row(width);
+    std::mutex progress_mutex;
+    float max_density = 0.0f;
+
+    for (int band = 0; band < bands; ++band)
+    {
+        int band_start = band * band_rows;
+        int band_end = std::min(band_start + band_rows, height);
+
+        std::unique_ptr<ProgressBar> progress;
+        if (!silent)
+            progress = std::make_unique<ProgressBar>(static_cast<int>(batches), "Band " + std::to_string(band + 1) + "/" + std::to_string(bands));
+
+        // Jedes Band zieht dieselben Samples (gleicher Seed pro Worker) und zählt nur seine Zeilen
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_workers; ++t)
+        {
+            BandJob job{width, height, band_start, band_end, max_iter, x_min, x_max, y_min, y_max, options.anti,
+                        options.samples / num_workers + (t < options.samples % num_workers),
+                        options.seed * 0x100000001B3ULL + t, &fractal, &map};
+            threads.emplace_back([&, job, t]()
+                                 {
+                                     numa_pin_worker(t);
+                                     hists[t].reset(width, band_rows); // First Touch auf dem Worker-Knoten
+                                     sampler(job, hists[t], progress.get(), progress_mutex); });
+        }
+        for (auto &t : threads)
+            t.join();
+        if (!silent)
+            std::cout << std::endl;
+
+        merge_histograms(hists, num_workers);
+
+        Histogram &merged = hists[0];
+        for (int y = 0; y < band_end - band_start; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                row[x] = merged.at(x, y);
+                max_density = std::max(max_density, row[x]);
+            }
+            if (bands > 1)
+                spill.write(reinterpret_cast<const char *>(row.data()), width * sizeof(float));
+        }
+    }
+
+    if (bands > 1)
+    {
+        hists.clear();
+        spill.flush();
+        spill.seekg(0);
+    }
+
+    // Wurzel-Tonwertkurve, Farben wie beim normalen Rendering
+    auto encoder = create_encoder(encoder_options);
+    if (!encoder->open(filename, width, height))
+    {
+        std::cerr << "Fehler: Konnte " << filename << " nicht öffnen." << std::endl;
+        return false;
+    }
+    std::vector<int> levels(width);
+    std::vector<uint8_t> bgr(static_cast<size_t>(width) * 3);
+    bool ok = true;
+    for (int y = 0; y < height && ok; ++y)
+    {
+        if (bands > 1)
+            ok = static_cast<bool>(spill.read(reinterpret_cast<char *>(row.data()), width * sizeof(float)));
+        else
+            for (int x = 0; x < width; ++x)
+                row[x] = hists[0].at(x, y);
+
+        for (int x = 0; x < width; ++x)
+            levels[x] = max_density > 0.0f ? static_cast<int>(DENSITY_LEVELS * std::sqrt(row[x] / max_density) + 0.5) : 0;
+        colorize_row(levels.data(), width, DENSITY_LEVELS, bgr.data());
+        ok = ok && encoder->write_row(bgr.data());
+    }
+    ok = encoder->close() && ok;
+
+    if (bands > 1)
+    {
+        spill.close();
+        fs::remove(spill_path);
+    }
+    if (!ok)
+        std::cerr << "Fehler: Konnte " << filename << " nicht schreiben." << std::endl;
+    return ok;
+}
@@ -4,81 +4,26 @@
 #include <cstdlib>
 #include <chrono>
 #include <filesystem>
-#include <png.h>
 #include <thread> // Für sleep_for
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "progress.hpp"
+#include "numa.hpp"
+#include "encoder.hpp"
+#include "async_io.hpp"
+#include "thread_pool.hpp"
 
-class ThreadPool
-{
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
-
-public:
-    explicit ThreadPool(size_t threads) : stop(false)
-    {
-        for (size_t i = 0; i < threads; ++i)
-            workers.emplace_back([this]
-                                 {
-                while(true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex);
-                        condition.wait(lock, [this] { 
-                            return stop || !tasks.empty(); 
-                        });
-                        if(stop && tasks.empty()) return;
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                    }
-                    task();
-                } });
-    }
-
-    template <class F>
-    auto enqueue(F &&f) -> std::future<typename std::invoke_result<F>::type>
-    {
-        using return_type = typename std::invoke_result<F>::type;
-        auto task = std::make_shared<std::packaged_task<return_type()>>(std::forward<F>(f));
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            tasks.emplace([task]()
-                          { (*task)(); });
-        }
-        condition.notify_one();
-        return res;
-    }
+namespace fs = std::filesystem;
 
-    ~ThreadPool()
-    {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers)
-            worker.join();
-    }
-};
-
-void write_image_chunked(const std::string &filename, int width, int height, int chunk_size, const std::string &temp_dir, int threads)
+void write_image_chunked(const std::string &filename, int width, int height, int chunk_size, const std::string &temp_dir, int threads, const EncoderOptions &encoder_options, const AsyncIOOptions &io_options)
 {
     const int total_chunks = (height + chunk_size - 1) / chunk_size;
-    const int chunks_per_temp = 10;
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    const size_t chunk_bytes = row_bytes * chunk_size;
 
-    struct TempFileInfo
-    {
-        std::string filename;
-        int start_chunk;
-        int num_chunks;
-        int start_row;
-    };
-    std::vector<TempFileInfo> temp_files;
-    std::mutex temp_files_mutex, cout_mutex;
+    std::mutex cout_mutex;
     std::atomic<int> processed_chunks{0};
 
     auto log = [&](const std::string &message)
@@ -90,135 +35,319 @@ void write_image_chunked(const std::string &filename, int width, int height, int
     log("Starte Verarbeitung...\n");
     log("Gesamtanzahl Chunks: " + std::to_string(total_chunks) + "\n");
 
-    ProgressBar chunkProgress(total_chunks, "Verarbeite Chunks");
+    // Chunks liegen im selben Format vor, mit dem sie erzeugt wurden
+    auto chunk_decoder = create_encoder(encoder_options);
 
-    auto process_chunk_range = [&](int start_chunk, int end_chunk, int temp_index)
+    std::vector<std::string> chunk_files(total_chunks);
+    size_t largest_file = 0;
+    for (int i = 0; i < total_chunks; ++i)
     {
-        std::string temp_filename = temp_dir + "/temp_" + std::to_string(temp_index) + ".tmp";
-        int start_row = start_chunk * chunk_size;
-        int total_rows = 0;
+        chunk_files[i] = temp_dir + "/chunk_" + std::to_string(i) + "." + chunk_decoder->extension();
+        std::error_code ec;
+        uintmax_t size = fs::file_size(chunk_files[i], ec);
+        if (!ec)
+            largest_file = std::max<size_t>(largest_file, size);
+    }
 
-        FILE *temp_fp = fopen(temp_filename.c_str(), "wb");
-        if (!temp_fp)
-        {
-            log("Fehler: Konnte temporäre Datei nicht erstellen: " + temp_filename + "\n");
-            return;
-        }
+    // Ein Puffer pro Warteschlangenplatz: nimmt erst die kodierte Datei, danach die dekodierten Zeilen auf
+    auto io = create_async_io(io_options, std::max(chunk_bytes, largest_file));
+    log("I/O-Backend: " + std::string(io->name()) + ", Tiefe " + std::to_string(io->depth()) + "\n");
 
-        for (int i = start_chunk; i < end_chunk && i < total_chunks; ++i)
-        {
-            std::string chunk_file = temp_dir + "/chunk_" + std::to_string(i) + ".png";
-            cv::Mat chunk = cv::imread(chunk_file, cv::IMREAD_COLOR);
+    // Alle Chunks landen per positionsgenauem Schreiben in einer Rohdatei
+    const std::string raw_filename = temp_dir + "/fusion.raw";
+    int raw_fd = open(raw_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (raw_fd < 0 || ftruncate(raw_fd, static_cast<off_t>(row_bytes) * height) != 0)
+    {
+        log("Fehler: Konnte temporäre Datei nicht erstellen: " + raw_filename + "\n");
+        if (raw_fd >= 0)
+            close(raw_fd);
+        return;
+    }
 
-            if (!chunk.empty())
-            {
-                fwrite(chunk.data, 1, chunk.step * chunk.rows, temp_fp);
-                total_rows += chunk.rows;
-                chunk.release();
-                processed_chunks++;
-                chunkProgress.update(processed_chunks);
-            }
-        }
+    enum : uint64_t
+    {
+        OP_READ = 0,
+        OP_WRITE = 1
+    };
+    auto make_tag = [](int slot, uint64_t op)
+    { return (static_cast<uint64_t>(slot) << 1) | op; };
 
-        fclose(temp_fp);
-        {
-            std::lock_guard<std::mutex> lock(temp_files_mutex);
-            temp_files.push_back({temp_filename,
-                                  start_chunk,
-                                  end_chunk - start_chunk,
-                                  start_row});
-        }
+    // Nicht abholbare Aufträge: Puffer bewusst nicht freigeben, der Kernel kann noch hineinschreiben
+    auto abandon_io = [&](const std::string &phase)
+    {
+        log("\nFehler: I/O-Backend liefert keine Abschlüsse mehr (" + phase + "), breche ab.\n");
+        io.release();
+        close(raw_fd);
+        std::remove(raw_filename.c_str());
     };
 
-    // Parallele Verarbeitung
+    auto chunk_rows = [&](int chunk)
+    { return std::min(chunk_size, height - chunk * chunk_size); };
+
+    // Nur vollständig in die Rohdatei geschriebene Chunks zählen als zusammengefügt
+    std::vector<char> chunk_fused(total_chunks, 0);
+
+    // Phase 1: Chunks lesen (async) -> dekodieren (Pool) -> in Rohdatei schreiben (async)
     {
+        ProgressBar chunkProgress(total_chunks, "Verarbeite Chunks");
+
+        struct Slot
+        {
+            int chunk = -1;
+            int fd = -1; // offen, solange der Lesezugriff aussteht
+            size_t size = 0;
+        };
+        std::vector<Slot> slots(io->depth());
+        std::vector<int> free_slots;
+        for (int slot = io->depth() - 1; slot >= 0; --slot)
+            free_slots.push_back(slot);
+
+        std::queue<std::pair<int, size_t>> decoded; // Platz, dekodierte Bytes (0 = Fehler)
+        std::mutex decoded_mutex;
+        std::condition_variable decoded_cv;
+
+        int next_chunk = 0, finished = 0, in_flight = 0, decoding = 0;
+
         ThreadPool pool(threads);
-        std::vector<std::future<void>> futures;
 
-        for (int i = 0; i < total_chunks; i += chunks_per_temp)
+        auto finish_chunk = [&](int slot)
         {
-            futures.push_back(pool.enqueue([=, &process_chunk_range]()
-                                           { process_chunk_range(
-                                                 i,
-                                                 std::min(i + chunks_per_temp, total_chunks),
-                                                 i / chunks_per_temp); }));
-        }
+            free_slots.push_back(slot);
+            finished++;
+        };
 
-        for (auto &future : futures)
+        while (finished < total_chunks)
         {
-            future.wait();
-        }
-    }
+            // Freie Plätze mit neuen Lesezugriffen füllen
+            while (!free_slots.empty() && next_chunk < total_chunks)
+            {
+                int chunk = next_chunk++;
+                int fd = open(chunk_files[chunk].c_str(), O_RDONLY);
+                struct stat st;
+                if (fd < 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) > io->buffer_size())
+                {
+                    log("Fehler: Konnte Chunk nicht lesen: " + chunk_files[chunk] + "\n");
+                    if (fd >= 0)
+                        close(fd);
+                    finished++;
+                    continue;
+                }
+
+                int slot = free_slots.back();
+                free_slots.pop_back();
+                slots[slot] = {chunk, fd, static_cast<size_t>(st.st_size)};
+                if (!io->submit_read(fd, slot, slots[slot].size, 0, make_tag(slot, OP_READ)))
+                {
+                    close(fd);
+                    slots[slot].fd = -1;
+                    finish_chunk(slot);
+                    continue;
+                }
+                in_flight++;
+            }
+
+            // Fertig dekodierte Chunks an ihre Position schreiben
+            {
+                std::lock_guard<std::mutex> lock(decoded_mutex);
+                while (!decoded.empty())
+                {
+                    auto [slot, bytes] = decoded.front();
+                    decoded.pop();
+                    decoding--;
 
-    // Sortiere nach Startzeile
-    std::sort(temp_files.begin(), temp_files.end(),
-              [](const TempFileInfo &a, const TempFileInfo &b)
-              {
-                  return a.start_row < b.start_row;
-              });
+                    off_t offset = static_cast<off_t>(slots[slot].chunk) * chunk_bytes;
+                    if (bytes == 0 || !io->submit_write(raw_fd, slot, bytes, offset, make_tag(slot, OP_WRITE)))
+                    {
+                        log("Fehler: Konnte Chunk " + std::to_string(slots[slot].chunk) + " nicht verarbeiten.\n");
+                        finish_chunk(slot);
+                        continue;
+                    }
+                    in_flight++;
+                }
+            }
 
-    log("\nErstelle finale PNG-Datei...\n");
+            uint64_t tag;
+            int result;
+            bool completed = decoding > 0 ? io->poll(tag, result) : io->wait(tag, result);
+            if (!completed && decoding == 0 && in_flight > 0)
+            {
+                for (const Slot &open_slot : slots)
+                    if (open_slot.fd >= 0)
+                        close(open_slot.fd);
+                abandon_io("Zusammenfügen");
+                return;
+            }
+            if (!completed)
+            {
+                if (decoding > 0)
+                {
+                    // Kurz auf den Dekoder warten, ausstehende I/O aber nicht liegen lassen
+                    std::unique_lock<std::mutex> lock(decoded_mutex);
+                    decoded_cv.wait_for(lock, std::chrono::milliseconds(in_flight > 0 ? 1 : 100),
+                                        [&]
+                                        { return !decoded.empty(); });
+                }
+                continue;
+            }
 
-    // PNG Initialisierung
-    FILE *fp = fopen(filename.c_str(), "wb");
-    if (!fp)
-    {
-        log("Fehler: Konnte finale Datei nicht öffnen.\n");
-        return;
+            in_flight--;
+            int slot = static_cast<int>(tag >> 1);
+
+            if ((tag & 1) == OP_WRITE)
+            {
+                int chunk = slots[slot].chunk;
+                if (result == static_cast<int>(chunk_rows(chunk) * row_bytes))
+                    chunk_fused[chunk] = 1;
+                else
+                    log("Fehler beim Schreiben von Chunk " + std::to_string(chunk) + "\n");
+                finish_chunk(slot);
+                processed_chunks++;
+                chunkProgress.update(processed_chunks);
+                continue;
+            }
+
+            close(slots[slot].fd);
+            slots[slot].fd = -1;
+            if (result != static_cast<int>(slots[slot].size))
+            {
+                log("Fehler: Konnte Chunk nicht lesen: " + chunk_files[slots[slot].chunk] + "\n");
+                finish_chunk(slot);
+                continue;
+            }
+
+            // Dekodieren läuft im Pool, während weitere Lese-/Schreibaufträge ausstehen
+            decoding++;
+            Slot info = slots[slot];
+            pool.enqueue([&, slot, info]()
+                         {
+                             uint8_t *buffer = io->buffer(slot);
+                             cv::Mat chunk = chunk_decoder->decode(buffer, info.size, width);
+                             size_t bytes = 0;
+                             int rows = chunk_rows(info.chunk);
+                             if (!chunk.empty() && chunk.cols == width && chunk.rows == rows)
+                             {
+                                 for (int y = 0; y < rows; ++y)
+                                     std::memcpy(buffer + y * row_bytes, chunk.ptr<uint8_t>(y), row_bytes);
+                                 bytes = rows * row_bytes;
+                             }
+                             else if (!chunk.empty())
+                             {
+                                 log("Fehler: " + chunk_files[info.chunk] + " hat " + std::to_string(chunk.cols) + "x" +
+                                     std::to_string(chunk.rows) + " Pixel, erwartet " + std::to_string(width) + "x" +
+                                     std::to_string(rows) + "\n");
+                             }
+                             {
+                                 std::lock_guard<std::mutex> lock(decoded_mutex);
+                                 decoded.emplace(slot, bytes);
+                             }
+                             decoded_cv.notify_one(); },
+                         io->buffer_node(slot));
+        }
     }
 
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-    png_infop info = png_create_info_struct(png);
+    log("\nErstelle finale Datei (" + encoder_options.format + ")...\n");
 
-    if (!png || !info || setjmp(png_jmpbuf(png)))
+    auto encoder = create_encoder(encoder_options);
+    if (!encoder->open(filename, width, height))
     {
-        log("Fehler bei PNG-Initialisierung.\n");
-        if (png)
-            png_destroy_write_struct(&png, info ? &info : nullptr);
-        fclose(fp);
+        log("Fehler: Konnte finale Datei nicht öffnen.\n");
+        close(raw_fd);
         return;
     }
 
-    png_init_io(png, fp);
-    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-    png_set_bgr(png);
-    png_write_info(png, info);
-
-    // Schreibe Daten
-    std::vector<uint8_t> row_buffer(width * 3);
+    // Phase 2: Rohdatei blockweise mit Vorauslesen in die finale Datei kodieren
+    const int total_blocks = total_chunks;
+    const int depth = io->depth();
+    std::vector<int> block_result(depth, 0);
+    std::vector<bool> block_done(depth, false);
     int total_rows = 0;
 
     ProgressBar writeProgress(height, "Schreibe Datei");
 
-    for (const auto &temp_info : temp_files)
+    auto block_rows = chunk_rows;
+
+    auto submit_block = [&](int block)
     {
-        FILE *temp_fp = fopen(temp_info.filename.c_str(), "rb");
-        if (!temp_fp)
-            continue;
+        int slot = block % depth;
+        block_done[slot] = false;
+        block_result[slot] = -1;
+        if (!io->submit_read(raw_fd, slot, block_rows(block) * row_bytes,
+                             static_cast<off_t>(block) * chunk_bytes, make_tag(slot, OP_READ)))
+        {
+            block_done[slot] = true;
+            block_result[slot] = -1;
+        }
+    };
 
-        for (int i = 0; i < temp_info.num_chunks && total_rows < height; ++i)
+    for (int block = 0; block < std::min(depth, total_blocks); ++block)
+        submit_block(block);
+
+    bool write_failed = false, io_failed = false;
+    for (int block = 0; block < total_blocks && !write_failed; ++block)
+    {
+        int slot = block % depth;
+        while (!block_done[slot])
         {
-            int rows_in_chunk = std::min(chunk_size, height - total_rows);
-            for (int row = 0; row < rows_in_chunk; ++row)
+            uint64_t tag;
+            int result;
+            if (!io->wait(tag, result))
             {
-                if (fread(row_buffer.data(), 1, width * 3, temp_fp) == width * 3)
-                {
-                    png_write_row(png, row_buffer.data());
-                    total_rows++;
-                    writeProgress.increment();
-                }
+                io_failed = true;
+                break;
+            }
+            block_done[tag >> 1] = true;
+            block_result[tag >> 1] = result;
+        }
+
+        if (io_failed)
+        {
+            encoder->close();
+            abandon_io("Schreiben");
+            return;
+        }
+
+        int rows = block_rows(block);
+        if (block_result[slot] != static_cast<int>(rows * row_bytes))
+        {
+            log("Fehler beim Lesen der temporären Datei.\n");
+            break;
+        }
+
+        const uint8_t *buffer = io->buffer(slot);
+        for (int row = 0; row < rows; ++row)
+        {
+            if (!encoder->write_row(buffer + row * row_bytes))
+            {
+                log("Fehler beim Schreiben der finalen Datei.\n");
+                write_failed = true;
+                break;
+            }
+            if (chunk_fused[block])
+            {
+                total_rows++;
+                writeProgress.increment();
             }
         }
 
-        fclose(temp_fp);
-        std::remove(temp_info.filename.c_str());
+        if (block + depth < total_blocks)
+            submit_block(block + depth);
+    }
+
+    // Ausstehende Lesezugriffe abholen, bevor Puffer und Datei freigegeben werden
+    uint64_t tag;
+    int result;
+    while (io->wait(tag, result))
+    {
     }
 
-    png_write_end(png, info);
-    png_destroy_write_struct(&png, &info);
-    fclose(fp);
+    if (!encoder->close())
+        log("Fehler beim Abschließen der finalen Datei.\n");
+
+    close(raw_fd);
+    std::remove(raw_filename.c_str());
 
     log("\nVerarbeitung abgeschlossen. " + std::to_string(total_rows) +
-        " von " + std::to_string(height) + " Zeilen geschrieben.\n");
-}
\ No newline at end of file
+        " von " + std::to_string(height) + " Zeilen zusammengefügt.\n");
+    if (total_rows < height)
+        log("Warnung: " + std::to_string(height - total_rows) + " Zeilen fehlen und bleiben schwarz.\n");
+}
@@ -0,0 +1,218 @@
+#include "distance.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "numa.hpp"
+#include "progress.hpp"
+
+// Portable Float Map, einkanalig; Zeilen liegen von unten nach oben, Skala < 0 = Little Endian
+class PfmWriter
+{
+private:
+    std::ofstream out;
+    int width = 0, height = 0;
+    std::streamoff header = 0;
+
+public:
+    bool open(const std::string &path, int w, int h)
+    {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        width = w;
+        height = h;
+        out << "Pf\n" << w << " " << h << "\n-1.0\n";
+        header = out.tellp();
+        return static_cast<bool>(out);
+    }
+
+    bool write_row(int y, const float *row)
+    {
+        out.seekp(header + static_cast<std::streamoff>(height - 1 - y) * width * sizeof(float));
+        out.write(reinterpret_cast<const char *>(row), width * sizeof(float));
+        return static_cast<bool>(out);
+    }
+
+    bool close()
+    {
+        out.close();
+        return !out.fail();
+    }
+};
+
+struct RowStats
+{
+    int64_t filled = 0;     // Pixel, deren Umgebung die Schätzung sicher ausschließt
+    int64_t subsamples = 0; // zusätzlich berechnete Subsamples
+};
+
+// Eine Zeile: erst alle Pixelpunkte, dann Subsamples nur für Pixel, die nicht sicher außerhalb liegen
+static void compute_distance_row(int y, int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter,
+                                 const FractalParams &fractal, const DistanceOptions &options, DistanceKernel kernel,
+                                 float *distance, uint8_t *bgr, RowStats &stats)
+{
+    const double dx = (x_max - x_min) / width;
+    const double dy = (y_max - y_min) / height;
+    const double diagonal = std::sqrt(dx * dx + dy * dy);
+    const double imag = y_min + (double(y) / height) * (y_max - y_min);
+    const int ss = std::max(1, options.supersample);
+
+    std::vector<double> re(width), im(width, imag), de(width);
+    for (int x = 0; x < width; ++x)
+        re[x] = x_min + x * dx;
+    kernel(re.data(), im.data(), width, max_iter, fractal, de.data());
+
+    auto shade = [&](double d)
+    {
+        return std::min(1.0, d / dx / options.line_width);
+    };
+
+    // Kreis mit Radius de um den Pixelpunkt ist frei von der Menge: deckt er die Pixelfläche ab, genügt ein Sample
+    std::vector<int> pending;
+    std::vector<double> sub_re, sub_im;
+    for (int x = 0; x < width; ++x)
+    {
+        if (ss > 1 && de[x] <= diagonal)
+        {
+            pending.push_back(x);
+            for (int j = 0; j < ss; ++j)
+            {
+                for (int i = 0; i < ss; ++i)
+                {
+                    sub_re.push_back(re[x] + (i + 0.5) / ss * dx);
+                    sub_im.push_back(imag + (j + 0.5) / ss * dy);
+                }
+            }
+            continue;
+        }
+        distance[x] = static_cast<float>(de[x] / dx);
+        std::fill_n(bgr + x * 3, 3, static_cast<uint8_t>(255 * shade(de[x]) + 0.5));
+        stats.filled += de[x] > diagonal;
+    }
+
+    if (pending.empty())
+        return;
+
+    std::vector<double> sub_de(sub_re.size());
+    kernel(sub_re.data(), sub_im.data(), static_cast<int>(sub_re.size()), max_iter, fractal, sub_de.data());
+    stats.subsamples += static_cast<int64_t>(sub_re.size());
+
+    for (size_t p = 0; p < pending.size(); ++p)
+    {
+        double sum_d = 0.0, sum_shade = 0.0;
+        for (int s = 0; s < ss * ss; ++s)
+        {
+            double d = sub_de[p * ss * ss + s];
+            sum_d += d;
+            sum_shade += shade(d);
+        }
+        int x = pending[p];
+        distance[x] = static_cast<float>(sum_d / (ss * ss) / dx);
+        std::fill_n(bgr + x * 3, 3, static_cast<uint8_t>(255 * sum_shade / (ss * ss) + 0.5));
+    }
+}
+
+bool generate_distance(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size,
+                       int num_workers, const FractalParams &fractal, const DistanceOptions &options, const std::string &filename,
+                       const EncoderOptions &encoder_options, bool silent)
+{
+    DistanceKernel kernel = select_distance_kernel(fractal);
+    if (!kernel)
+    {
+        std::cerr << "Fehler: Distanzschätzung wird nur für Mandelbrot/Multibrot und Julia unterstützt." << std::endl;
+        return false;
+    }
+
+    PfmWriter pfm;
+    if (!options.float_path.empty() && !pfm.open(options.float_path, width, height))
+    {
+        std::cerr << "Fehler: Konnte " << options.float_path << " nicht öffnen." << std::endl;
+        return false;
+    }
+    auto encoder = create_encoder(encoder_options);
+    if (!encoder->open(filename, width, height))
+    {
+        std::cerr << "Fehler: Konnte " << filename << " nicht öffnen." << std::endl;
+        return false;
+    }
+
+    const int ss = std::max(1, options.supersample);
+    std::vector<float> distance(static_cast<size_t>(chunk_size) * width);
+    std::vector<uint8_t> bgr(static_cast<size_t>(chunk_size) * width * 3);
+    std::vector<RowStats> stats(num_workers);
+    std::unique_ptr<ProgressBar> progress;
+    std::mutex progress_mutex;
+    if (!silent)
+        progress = std::make_unique<ProgressBar>(height, "Distanz");
+
+    bool ok = true;
+    for (int band_start = 0; band_start < height && ok; band_start += chunk_size)
+    {
+        int band_end = std::min(band_start + chunk_size, height);
+        std::atomic<int> next_row{band_start};
+
+        // Zeilen am Rand der Menge kosten ein Vielfaches, daher dynamisch verteilen
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_workers; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                                     numa_pin_worker(t);
+                                     for (int y = next_row++; y < band_end; y = next_row++)
+                                     {
+                                         size_t offset = static_cast<size_t>(y - band_start) * width;
+                                         compute_distance_row(y, width, height, x_min, x_max, y_min, y_max, max_iter, fractal, options,
+                                                              kernel, distance.data() + offset, bgr.data() + offset * 3, stats[t]);
+                                         if (progress)
+                                         {
+                                             std::lock_guard<std::mutex> lock(progress_mutex);
+                                             progress->increment();
+                                         }
+                                     } });
+        }
+        for (auto &t : threads)
+            t.join();
+
+        for (int y = band_start; y < band_end && ok; ++y)
+        {
+            size_t offset = static_cast<size_t>(y - band_start) * width;
+            ok = encoder->write_row(bgr.data() + offset * 3);
+            if (ok && !options.float_path.empty())
+                ok = pfm.write_row(y, distance.data() + offset);
+        }
+    }
+    if (!silent)
+        std::cout << std::endl;
+
+    ok = encoder->close() && ok;
+    if (!options.float_path.empty())
+        ok = pfm.close() && ok;
+    if (!ok)
+    {
+        std::cerr << "Fehler: Konnte die Ausgabe nicht schreiben." << std::endl;
+        return false;
+    }
+
+    RowStats total;
+    for (const auto &s : stats)
+    {
+        total.filled += s.filled;
+        total.subsamples += s.subsamples;
+    }
+    int64_t pixels = static_cast<int64_t>(width) * height;
+    int64_t computed = pixels + total.subsamples;
+    int64_t plain = pixels * ss * ss;
+    std::cout << "Sicher außen: " << total.filled << " von " << pixels << " Pixeln" << std::endl;
+    if (ss > 1)
+        std::cout << "Samples: " << computed << " statt " << plain << " bei " << ss << "x" << ss << "-Überabtastung ("
+                  << static_cast<int>(100.0 * (1.0 - double(computed) / plain)) << "% gespart)" << std::endl;
+    if (!options.float_path.empty())
+        std::cout << "Distanzen (Pixel): " << options.float_path << std::endl;
+    return true;
+}
@@ -0,0 +1,618 @@
+#include "encoder.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <png.h>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+bool ImageEncoder::write(const std::string &path, const cv::Mat &image)
+{
+    if (!open(path, image.cols, image.rows))
+        return false;
+    for (int y = 0; y < image.rows; ++y)
+    {
+        if (!write_row(image.ptr<uint8_t>(y)))
+        {
+            close();
+            return false;
+        }
+    }
+    return close();
+}
+
+cv::Mat ImageEncoder::read(const std::string &path, int width) const
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp)
+        return cv::Mat();
+
+    std::vector<uint8_t> data;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size > 0)
+    {
+        data.resize(size);
+        if (fread(data.data(), 1, data.size(), fp) != data.size())
+            data.clear();
+    }
+    fclose(fp);
+
+    if (data.empty())
+        return cv::Mat();
+    return decode(data.data(), data.size(), width);
+}
+
+// ---------------------------------------------------------------------------
+// PNG (libpng, Level/Strategie/Filter einstellbar)
+// ---------------------------------------------------------------------------
+
+class PngEncoder : public ImageEncoder
+{
+private:
+    EncoderOptions options;
+    FILE *fp = nullptr;
+    png_structp png = nullptr;
+    png_infop info = nullptr;
+
+    int strategy() const
+    {
+        if (options.png_strategy == "filtered")
+            return Z_FILTERED;
+        if (options.png_strategy == "huffman")
+            return Z_HUFFMAN_ONLY;
+        if (options.png_strategy == "rle")
+            return Z_RLE;
+        if (options.png_strategy == "fixed")
+            return Z_FIXED;
+        return Z_DEFAULT_STRATEGY;
+    }
+
+    int filters() const
+    {
+        int mask = 0;
+        std::stringstream ss(options.png_filters);
+        std::string name;
+        while (std::getline(ss, name, ','))
+        {
+            if (name == "none")
+                mask |= PNG_FILTER_NONE;
+            else if (name == "sub")
+                mask |= PNG_FILTER_SUB;
+            else if (name == "up")
+                mask |= PNG_FILTER_UP;
+            else if (name == "avg")
+                mask |= PNG_FILTER_AVG;
+            else if (name == "paeth")
+                mask |= PNG_FILTER_PAETH;
+            else if (name == "all")
+                mask |= PNG_ALL_FILTERS;
+        }
+        return mask ? mask : PNG_ALL_FILTERS;
+    }
+
+    void cleanup()
+    {
+        if (png)
+            png_destroy_write_struct(&png, info ? &info : nullptr);
+        png = nullptr;
+        info = nullptr;
+        if (fp)
+            fclose(fp);
+        fp = nullptr;
+    }
+
+public:
+    explicit PngEncoder(const EncoderOptions &options) : options(options) {}
+    ~PngEncoder() override { cleanup(); }
+
+    std::string extension() const override { return "png"; }
+
+    bool open(const std::string &path, int width, int height) override
+    {
+        fp = fopen(path.c_str(), "wb");
+        if (!fp)
+            return false;
+
+        png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        info = png ? png_create_info_struct(png) : nullptr;
+
+        // libpng springt bei Fehlern per longjmp zurück, daher setjmp in jeder Methode
+        if (!png || !info || setjmp(png_jmpbuf(png)))
+        {
+            cleanup();
+            return false;
+        }
+
+        png_init_io(png, fp);
+        png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        if (options.png_level >= 0)
+            png_set_compression_level(png, options.png_level);
+        png_set_compression_strategy(png, strategy());
+        png_set_filter(png, PNG_FILTER_TYPE_BASE, filters());
+        png_set_bgr(png);
+        png_write_info(png, info);
+        return true;
+    }
+
+    bool write_row(const uint8_t *bgr) override
+    {
+        if (!png || setjmp(png_jmpbuf(png)))
+        {
+            cleanup();
+            return false;
+        }
+        png_write_row(png, const_cast<uint8_t *>(bgr));
+        return true;
+    }
+
+    bool close() override
+    {
+        if (!png)
+            return false;
+        if (setjmp(png_jmpbuf(png)))
+        {
+            cleanup();
+            return false;
+        }
+        png_write_end(png, info);
+        cleanup();
+        return true;
+    }
+
+    cv::Mat decode(const uint8_t *data, size_t size, int) const override
+    {
+        cv::Mat buffer(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t *>(data));
+        return cv::imdecode(buffer, cv::IMREAD_COLOR);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// QOI (https://qoiformat.org), schnell und verlustfrei
+// ---------------------------------------------------------------------------
+
+class QoiEncoder : public ImageEncoder
+{
+private:
+    static constexpr uint8_t OP_INDEX = 0x00;
+    static constexpr uint8_t OP_DIFF = 0x40;
+    static constexpr uint8_t OP_LUMA = 0x80;
+    static constexpr uint8_t OP_RUN = 0xc0;
+    static constexpr uint8_t OP_RGB = 0xfe;
+    static constexpr uint8_t OP_RGBA = 0xff;
+    static constexpr uint8_t MASK_2 = 0xc0;
+
+    struct Pixel
+    {
+        uint8_t r, g, b, a;
+    };
+
+    FILE *fp = nullptr;
+    int width = 0;
+    Pixel index[64];
+    Pixel prev;
+    int run = 0;
+    std::vector<uint8_t> out;
+
+    static int hash(const Pixel &p)
+    {
+        return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+    }
+
+    static void put_u32(std::vector<uint8_t> &buf, uint32_t v)
+    {
+        buf.push_back(v >> 24);
+        buf.push_back(v >> 16);
+        buf.push_back(v >> 8);
+        buf.push_back(v);
+    }
+
+    void flush_run()
+    {
+        if (run > 0)
+        {
+            out.push_back(OP_RUN | (run - 1));
+            run = 0;
+        }
+    }
+
+    bool flush()
+    {
+        bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+        out.clear();
+        return ok;
+    }
+
+public:
+    ~QoiEncoder() override { if (fp) fclose(fp); }
+
+    std::string extension() const override { return "qoi"; }
+
+    bool open(const std::string &path, int w, int h) override
+    {
+        fp = fopen(path.c_str(), "wb");
+        if (!fp)
+            return false;
+
+        width = w;
+        std::memset(index, 0, sizeof(index));
+        prev = {0, 0, 0, 255};
+        run = 0;
+        out.clear();
+        out.reserve(static_cast<size_t>(width) * 4 + 16);
+
+        out.insert(out.end(), {'q', 'o', 'i', 'f'});
+        put_u32(out, w);
+        put_u32(out, h);
+        out.push_back(3); // RGB
+        out.push_back(0); // sRGB
+        return flush();
+    }
+
+    bool write_row(const uint8_t *bgr) override
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            Pixel px{bgr[x * 3 + 2], bgr[x * 3 + 1], bgr[x * 3 + 0], 255};
+
+            if (std::memcmp(&px, &prev, sizeof(Pixel)) == 0)
+            {
+                if (++run == 62)
+                    flush_run();
+                continue;
+            }
+            flush_run();
+
+            int h = hash(px);
+            if (std::memcmp(&index[h], &px, sizeof(Pixel)) == 0)
+            {
+                out.push_back(OP_INDEX | h);
+            }
+            else
+            {
+                index[h] = px;
+                int8_t vr = px.r - prev.r;
+                int8_t vg = px.g - prev.g;
+                int8_t vb = px.b - prev.b;
+                int8_t vg_r = vr - vg;
+                int8_t vg_b = vb - vg;
+
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                {
+                    out.push_back(OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                }
+                else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+                {
+                    out.push_back(OP_LUMA | (vg + 32));
+                    out.push_back((vg_r + 8) << 4 | (vg_b + 8));
+                }
+                else
+                {
+                    out.push_back(OP_RGB);
+                    out.push_back(px.r);
+                    out.push_back(px.g);
+                    out.push_back(px.b);
+                }
+            }
+            prev = px;
+        }
+        return flush();
+    }
+
+    bool close() override
+    {
+        if (!fp)
+            return false;
+        flush_run();
+        out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+        bool ok = flush();
+        ok = fclose(fp) == 0 && ok;
+        fp = nullptr;
+        return ok;
+    }
+
+    cv::Mat decode(const uint8_t *data, size_t size, int) const override
+    {
+        if (size < 14 + 8 || std::memcmp(data, "qoif", 4) != 0)
+            return cv::Mat();
+
+        auto get_u32 = [&](size_t pos)
+        {
+            return uint32_t(data[pos]) << 24 | uint32_t(data[pos + 1]) << 16 | uint32_t(data[pos + 2]) << 8 | data[pos + 3];
+        };
+        int w = static_cast<int>(get_u32(4));
+        int h = static_cast<int>(get_u32(8));
+        if (w <= 0 || h <= 0)
+            return cv::Mat();
+
+        cv::Mat image(h, w, CV_8UC3);
+        Pixel idx[64];
+        std::memset(idx, 0, sizeof(idx));
+        Pixel px{0, 0, 0, 255};
+        int px_run = 0;
+        size_t p = 14;
+        size_t end = size - 8;
+
+        for (int y = 0; y < h; ++y)
+        {
+            uint8_t *row = image.ptr<uint8_t>(y);
+            for (int x = 0; x < w; ++x)
+            {
+                if (px_run > 0)
+                {
+                    px_run--;
+                }
+                else if (p < end)
+                {
+                    uint8_t b1 = data[p++];
+                    if (b1 == OP_RGB)
+                    {
+                        px.r = data[p++];
+                        px.g = data[p++];
+                        px.b = data[p++];
+                    }
+                    else if (b1 == OP_RGBA)
+                    {
+                        px.r = data[p++];
+                        px.g = data[p++];
+                        px.b = data[p++];
+                        px.a = data[p++];
+                    }
+                    else if ((b1 & MASK_2) == OP_INDEX)
+                    {
+                        px = idx[b1];
+                    }
+                    else if ((b1 & MASK_2) == OP_DIFF)
+                    {
+                        px.r += ((b1 >> 4) & 0x03) - 2;
+                        px.g += ((b1 >> 2) & 0x03) - 2;
+                        px.b += (b1 & 0x03) - 2;
+                    }
+                    else if ((b1 & MASK_2) == OP_LUMA)
+                    {
+                        uint8_t b2 = data[p++];
+                        int vg = (b1 & 0x3f) - 32;
+                        px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                        px.g += vg;
+                        px.b += vg - 8 + (b2 & 0x0f);
+                    }
+                    else if ((b1 & MASK_2) == OP_RUN)
+                    {
+                        px_run = (b1 & 0x3f);
+                    }
+                    idx[hash(px)] = px;
+                }
+
+                row[x * 3 + 0] = px.b;
+                row[x * 3 + 1] = px.g;
+                row[x * 3 + 2] = px.r;
+            }
+        }
+        return image;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// PPM (P6) und Rohdaten (BGR ohne Header)
+// ---------------------------------------------------------------------------
+
+class PpmEncoder : public ImageEncoder
+{
+private:
+    FILE *fp = nullptr;
+    int width = 0;
+    std::vector<uint8_t> rgb;
+
+public:
+    ~PpmEncoder() override { if (fp) fclose(fp); }
+
+    std::string extension() const override { return "ppm"; }
+
+    bool open(const std::string &path, int w, int h) override
+    {
+        fp = fopen(path.c_str(), "wb");
+        if (!fp)
+            return false;
+        width = w;
+        rgb.resize(static_cast<size_t>(w) * 3);
+        return fprintf(fp, "P6\n%d %d\n255\n", w, h) > 0;
+    }
+
+    bool write_row(const uint8_t *bgr) override
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            rgb[x * 3 + 0] = bgr[x * 3 + 2];
+            rgb[x * 3 + 1] = bgr[x * 3 + 1];
+            rgb[x * 3 + 2] = bgr[x * 3 + 0];
+        }
+        return fwrite(rgb.data(), 1, rgb.size(), fp) == rgb.size();
+    }
+
+    bool close() override
+    {
+        if (!fp)
+            return false;
+        bool ok = fclose(fp) == 0;
+        fp = nullptr;
+        return ok;
+    }
+
+    cv::Mat decode(const uint8_t *data, size_t size, int) const override
+    {
+        // Header: "P6" <ws> width <ws> height <ws> maxval <ein ws>, Kommentare mit '#'
+        size_t p = 2;
+        int fields[3] = {0, 0, 0};
+        if (size < 2 || data[0] != 'P' || data[1] != '6')
+            return cv::Mat();
+        for (int &field : fields)
+        {
+            while (p < size && (std::isspace(data[p]) || data[p] == '#'))
+            {
+                if (data[p] == '#')
+                    while (p < size && data[p] != '\n')
+                        p++;
+                else
+                    p++;
+            }
+            while (p < size && std::isdigit(data[p]))
+                field = field * 10 + (data[p++] - '0');
+        }
+        p++;
+
+        int w = fields[0], h = fields[1];
+        if (w <= 0 || h <= 0 || fields[2] != 255 || p + static_cast<size_t>(w) * h * 3 > size)
+            return cv::Mat();
+
+        cv::Mat image(h, w, CV_8UC3);
+        for (int y = 0; y < h; ++y)
+        {
+            const uint8_t *src = data + p + static_cast<size_t>(y) * w * 3;
+            uint8_t *row = image.ptr<uint8_t>(y);
+            for (int x = 0; x < w; ++x)
+            {
+                row[x * 3 + 0] = src[x * 3 + 2];
+                row[x * 3 + 1] = src[x * 3 + 1];
+                row[x * 3 + 2] = src[x * 3 + 0];
+            }
+        }
+        return image;
+    }
+};
+
+class RawEncoder : public ImageEncoder
+{
+private:
+    FILE *fp = nullptr;
+    size_t row_bytes = 0;
+
+public:
+    ~RawEncoder() override { if (fp) fclose(fp); }
+
+    std::string extension() const override { return "raw"; }
+
+    bool open(const std::string &path, int w, int) override
+    {
+        fp = fopen(path.c_str(), "wb");
+        row_bytes = static_cast<size_t>(w) * 3;
+        return fp != nullptr;
+    }
+
+    bool write_row(const uint8_t *bgr) override
+    {
+        return fwrite(bgr, 1, row_bytes, fp) == row_bytes;
+    }
+
+    bool close() override
+    {
+        if (!fp)
+            return false;
+        bool ok = fclose(fp) == 0;
+        fp = nullptr;
+        return ok;
+    }
+
+    cv::Mat decode(const uint8_t *data, size_t size, int width) const override
+    {
+        size_t row = static_cast<size_t>(width) * 3;
+        if (width <= 0 || size < row)
+            return cv::Mat();
+
+        int rows = static_cast<int>(size / row);
+        cv::Mat image(rows, width, CV_8UC3);
+        std::memcpy(image.data, data, row * rows);
+        return image;
+    }
+};
+
+bool is_known_format(const std::string &format)
+{
+    return format == "png" || format == "qoi" || format == "ppm" || format == "raw";
+}
+
+bool is_known_png_strategy(const std::string &strategy)
+{
+    return strategy == "default" || strategy == "filtered" || strategy == "huffman" || strategy == "rle" || strategy == "fixed";
+}
+
+bool is_known_png_filters(const std::string &filters)
+{
+    std::stringstream ss(filters);
+    std::string name;
+    int count = 0;
+    while (std::getline(ss, name, ','))
+    {
+        if (name != "none" && name != "sub" && name != "up" && name != "avg" && name != "paeth" && name != "all")
+            return false;
+        count++;
+    }
+    return count > 0;
+}
+
+std::unique_ptr<ImageEncoder> create_encoder(const EncoderOptions &options)
+{
+    if (options.format == "qoi")
+        return std::make_unique<QoiEncoder>();
+    if (options.format == "ppm")
+        return std::make_unique<PpmEncoder>();
+    if (options.format == "raw")
+        return std::make_unique<RawEncoder>();
+    if (options.format == "png")
+        return std::make_unique<PngEncoder>(options);
+    return nullptr;
+}
+
+void benchmark_encoders(const cv::Mat &image, const EncoderOptions &options, const std::string &temp_dir)
+{
+    const double raw_mb = double(image.cols) * image.rows * 3 / (1024.0 * 1024.0);
+
+    std::cout << "Encoder-Benchmark (" << image.cols << "x" << image.rows << ", "
+              << std::fixed << std::setprecision(1) << raw_mb << " MB Rohdaten)" << std::endl;
+    std::cout << std::left << std::setw(8) << "Format" << std::right
+              << std::setw(14) << "Bytes" << std::setw(10) << "Ratio"
+              << std::setw(14) << "Enc MB/s" << std::setw(14) << "Dec MB/s" << std::endl;
+
+    fs::create_directories(temp_dir);
+
+    for (const std::string format : {"png", "qoi", "ppm", "raw"})
+    {
+        EncoderOptions opts = options;
+        opts.format = format;
+        auto encoder = create_encoder(opts);
+        std::string path = temp_dir + "/bench." + encoder->extension();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bool ok = encoder->write(path, image);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        cv::Mat decoded = ok ? encoder->read(path, image.cols) : cv::Mat();
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        if (!ok)
+        {
+            std::cerr << "Fehler: Konnte " << path << " nicht schreiben." << std::endl;
+            continue;
+        }
+
+        uintmax_t bytes = fs::file_size(path);
+        double enc = std::chrono::duration<double>(t1 - t0).count();
+        double dec = std::chrono::duration<double>(t2 - t1).count();
+        bool roundtrip = !decoded.empty() && decoded.rows == image.rows && decoded.cols == image.cols;
+
+        std::cout << std::left << std::setw(8) << format << std::right
+                  << std::setw(14) << bytes
+                  << std::setw(10) << std::setprecision(3) << (double(bytes) / (raw_mb * 1024.0 * 1024.0))
+                  << std::setw(14) << std::setprecision(1) << (raw_mb / enc)
+                  << std::setw(14) << (roundtrip ? raw_mb / dec : 0.0)
+                  << (roundtrip ? "" : "  (Dekodierung fehlgeschlagen)") << std::endl;
+
+        fs::remove(path);
+    }
+}
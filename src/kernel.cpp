@@ -0,0 +1,131 @@
+#include "kernel.hpp"
+#include <utility>
+
+static KernelVariant active_variant = KernelVariant::SSE2;
+
+template <Formula F, int P>
+static RowKernel variant_kernel(KernelVariant variant)
+{
+    switch (variant)
+    {
+    case KernelVariant::Scalar:
+        return &kernel::row_scalar<F, P>;
+    case KernelVariant::SSE2x2:
+        return &kernel::row<F, P, 2>;
+    case KernelVariant::SSE2:
+    default:
+        return &kernel::row<F, P, 1>;
+    }
+}
+
+// Tabelle aller Spezialisierungen einer Formel für die Potenzen MIN..MAX
+template <Formula F, int... Ps>
+static RowKernel pick(int power, KernelVariant variant, std::integer_sequence<int, Ps...>)
+{
+    using Selector = RowKernel (*)(KernelVariant);
+    static const Selector table[] = {&variant_kernel<F, Ps + KERNEL_MIN_POWER>...};
+    int idx = power - KERNEL_MIN_POWER;
+    if (idx < 0 || idx >= static_cast<int>(sizeof...(Ps)))
+        return nullptr;
+    return table[idx](variant);
+}
+
+RowKernel select_kernel(const FractalParams &params, KernelVariant variant)
+{
+    using Powers = std::make_integer_sequence<int, KERNEL_MAX_POWER - KERNEL_MIN_POWER + 1>;
+    switch (params.formula)
+    {
+    case Formula::Julia:
+        return pick<Formula::Julia>(params.power, variant, Powers{});
+    case Formula::BurningShip:
+        return pick<Formula::BurningShip>(params.power, variant, Powers{});
+    case Formula::Mandelbrot:
+    default:
+        return pick<Formula::Mandelbrot>(params.power, variant, Powers{});
+    }
+}
+
+template <Formula F, int... Ps>
+static DistanceKernel pick_distance(int power, std::integer_sequence<int, Ps...>)
+{
+    static const DistanceKernel table[] = {&kernel::points_de<F, Ps + KERNEL_MIN_POWER>...};
+    int idx = power - KERNEL_MIN_POWER;
+    if (idx < 0 || idx >= static_cast<int>(sizeof...(Ps)))
+        return nullptr;
+    return table[idx];
+}
+
+DistanceKernel select_distance_kernel(const FractalParams &params)
+{
+    using Powers = std::make_integer_sequence<int, KERNEL_MAX_POWER - KERNEL_MIN_POWER + 1>;
+    switch (params.formula)
+    {
+    case Formula::Julia:
+        return pick_distance<Formula::Julia>(params.power, Powers{});
+    case Formula::Mandelbrot:
+        return pick_distance<Formula::Mandelbrot>(params.power, Powers{});
+    default:
+        return nullptr;
+    }
+}
+
+RowKernel select_kernel(const FractalParams &params)
+{
+    return select_kernel(params, active_variant);
+}
+
+void set_kernel_variant(KernelVariant variant)
+{
+    active_variant = variant;
+}
+
+KernelVariant kernel_variant()
+{
+    return active_variant;
+}
+
+const char *kernel_variant_name(KernelVariant variant)
+{
+    switch (variant)
+    {
+    case KernelVariant::Scalar:
+        return "scalar";
+    case KernelVariant::SSE2x2:
+        return "sse2x2";
+    case KernelVariant::SSE2:
+    default:
+        return "sse2";
+    }
+}
+
+bool parse_kernel_variant(const std::string &name, KernelVariant &variant)
+{
+    for (KernelVariant v : {KernelVariant::Scalar, KernelVariant::SSE2, KernelVariant::SSE2x2})
+    {
+        if (name == kernel_variant_name(v))
+        {
+            variant = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string fractal_name(const FractalParams &params)
+{
+    std::string name;
+    switch (params.formula)
+    {
+    case Formula::Julia:
+        name = "Julia (k = " + std::to_string(params.julia_re) + " + " + std::to_string(params.julia_im) + "i)";
+        break;
+    case Formula::BurningShip:
+        name = "Burning Ship";
+        break;
+    case Formula::Mandelbrot:
+    default:
+        name = params.power == 2 ? "Mandelbrot" : "Multibrot";
+        break;
+    }
+    return name + ", z^" + std::to_string(params.power);
+}
@@ -3,23 +3,30 @@
 #include <cstdlib>
 #include <chrono>
 #include <filesystem>
-#include <png.h>
 #include "mandelbrot.hpp"
 #include "combine.hpp"
+#include "numa.hpp"
+#include "encoder.hpp"
+#include "tile_cache.hpp"
+#include "async_io.hpp"
+#include "batch.hpp"
+#include "tune.hpp"
+#include "buddhabrot.hpp"
+#include "distance.hpp"
 
 namespace fs = std::filesystem;
 
-void chunk_limited(int width, int height, int x_min, int x_max, int y_min, int y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string chunk_path, bool silent)
+void chunk_limited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string chunk_path, bool silent, const EncoderOptions &encoder_options, const FractalParams &fractal)
 {
     std::cout << "Berechne nur Chunks von " << chunk_start << " bis " << chunk_end << std::endl;
     std::cout << "Speichere Chunks in: " << chunk_path << std::endl;
 
     fs::create_directory(chunk_path);
     std::cout << "Generiere Mandelbrot-Menge..." << std::endl;
-    generate_mandelbrot_limited(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, chunk_start, chunk_end, chunk_path, silent);
+    generate_mandelbrot_limited(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, chunk_start, chunk_end, chunk_path, silent, encoder_options, fractal);
 }
 
-void chunk_unlimited(int width, int height, int x_min, int x_max, int y_min, int y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, std::string filename, bool silent, bool delete_cache, int threads)
+void chunk_unlimited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, std::string filename, bool silent, bool delete_cache, int threads, const EncoderOptions &encoder_options, const FractalParams &fractal, const AsyncIOOptions &io_options)
 {
     std::cout << "Dateiname: " << filename << std::endl;
 
@@ -27,10 +34,10 @@ void chunk_unlimited(int width, int height, int x_min, int x_max, int y_min, int
 
     // Mandelbrot berechnen
     std::cout << "Generiere Mandelbrot-Menge..." << std::endl;
-    generate_mandelbrot_chunked(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, temp_dir, silent);
+    generate_mandelbrot_chunked(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, temp_dir, silent, encoder_options, fractal);
 
     std::cout << "Füge Chunks zusammen und speichere Bild..." << std::endl;
-    write_image_chunked(filename, width, height, chunk_size, temp_dir, threads);
+    write_image_chunked(filename, width, height, chunk_size, temp_dir, threads, encoder_options, io_options);
 
     if (delete_cache)
     {
@@ -39,14 +46,14 @@ void chunk_unlimited(int width, int height, int x_min, int x_max, int y_min, int
     }
 }
 
-void chunk_intervall(int width, int height, int x_min, int x_max, int y_min, int y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string chunk_path, bool silent, int offset)
+void chunk_intervall(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string chunk_path, bool silent, int offset, const EncoderOptions &encoder_options, const FractalParams &fractal)
 {
     std::cout << "Berechne Chunks in Intervallen von " << intervall << std::endl;
     std::cout << "Speichere Chunks in: " << chunk_path << std::endl;
 
     fs::create_directory(chunk_path);
     std::cout << "Generiere Mandelbrot-Menge..." << std::endl;
-    generate_mandelbrot_intervall(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, intervall, chunk_path, silent, offset);
+    generate_mandelbrot_intervall(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, intervall, chunk_path, silent, offset, encoder_options, fractal);
 }
 
 int main(int argc, char **argv)
@@ -62,9 +69,17 @@ int main(int argc, char **argv)
 
     int width = 2800, height = 1600, max_iter = 100, chunk_size = 100, num_workers = 3;
     double x_min = -2.0, x_max = 1.0, y_min = -1.5, y_max = 1.5;
-    std::string filename = "mandelbrot.png", chunk_path = "chunks";
-    int chunk_start = -1, chunk_end = -1, intervall = -1, offset = 0;
-    bool silent = false, fusion = false, delete_cache = false;
+    std::string filename = "mandelbrot.png", chunk_path = "chunks", cache_dir, batch_file, batch_report = "batch_report.csv", profile_path = host_profile_path();
+    int chunk_start = -1, chunk_end = -1, intervall = -1, offset = 0, cache_mem = 256;
+    bool silent = false, fusion = false, delete_cache = false, numa = false, bench_encode = false, filename_set = false;
+    bool tune = false, use_profile = true, workers_set = false, chunk_size_set = false, kernel_set = false;
+    EncoderOptions encoder_options;
+    FractalParams fractal;
+    AsyncIOOptions io_options;
+    BuddhabrotOptions buddha_options;
+    bool buddhabrot = false;
+    DistanceOptions distance_options;
+    bool distance = false;
 
     auto nextIntArg = [&](int &i)
     {
@@ -104,9 +119,15 @@ int main(int argc, char **argv)
         else if (arg == "--max_iter")
             max_iter = nextIntArg(i);
         else if (arg == "--chunk_size")
+        {
             chunk_size = nextIntArg(i);
+            chunk_size_set = true;
+        }
         else if ((arg == "--workers") || (arg == "-j"))
+        {
             num_workers = nextIntArg(i);
+            workers_set = true;
+        }
         else if (arg == "--filename")
         {
             if (++i >= argc)
@@ -115,6 +136,7 @@ int main(int argc, char **argv)
                 std::exit(1);
             }
             filename = argv[i];
+            filename_set = true;
         }
         else if (arg == "--chunk_start")
             chunk_start = nextIntArg(i);
@@ -142,6 +164,141 @@ int main(int argc, char **argv)
             intervall = nextIntArg(i);
         else if (arg == "--offset")
             offset = nextIntArg(i);
+        else if (arg == "--numa")
+            numa = true;
+        else if (arg == "--format")
+        {
+            if (++i >= argc || !is_known_format(argv[i]))
+            {
+                std::cerr << "Fehler: --format erwartet png, qoi, ppm oder raw" << std::endl;
+                std::exit(1);
+            }
+            encoder_options.format = argv[i];
+        }
+        else if (arg == "--png_level")
+        {
+            encoder_options.png_level = nextIntArg(i);
+            if (encoder_options.png_level < 0 || encoder_options.png_level > 9)
+            {
+                std::cerr << "Fehler: --png_level muss zwischen 0 und 9 liegen" << std::endl;
+                std::exit(1);
+            }
+        }
+        else if (arg == "--png_strategy")
+        {
+            if (++i >= argc || !is_known_png_strategy(argv[i]))
+            {
+                std::cerr << "Fehler: --png_strategy erwartet default, filtered, huffman, rle oder fixed" << std::endl;
+                std::exit(1);
+            }
+            encoder_options.png_strategy = argv[i];
+        }
+        else if (arg == "--png_filters")
+        {
+            if (++i >= argc || !is_known_png_filters(argv[i]))
+            {
+                std::cerr << "Fehler: --png_filters erwartet all, none, sub, up, avg, paeth (kommagetrennt)" << std::endl;
+                std::exit(1);
+            }
+            encoder_options.png_filters = argv[i];
+        }
+        else if (arg == "--bench_encode")
+            bench_encode = true;
+        else if (arg == "--power")
+            fractal.power = nextIntArg(i);
+        else if (arg == "--julia")
+        {
+            fractal.formula = Formula::Julia;
+            fractal.julia_re = nextDoubleArg(i);
+            fractal.julia_im = nextDoubleArg(i);
+        }
+        else if (arg == "--burning_ship")
+            fractal.formula = Formula::BurningShip;
+        else if (arg == "--cache")
+        {
+            if (++i >= argc)
+            {
+                std::cerr << "Fehler: fehlender Wert für --cache" << std::endl;
+                std::exit(1);
+            }
+            cache_dir = argv[i];
+        }
+        else if (arg == "--cache_mem")
+            cache_mem = nextIntArg(i);
+        else if (arg == "--batch" || arg == "--batch_report")
+        {
+            if (++i >= argc)
+            {
+                std::cerr << "Fehler: fehlender Wert für " << arg << std::endl;
+                std::exit(1);
+            }
+            (arg == "--batch" ? batch_file : batch_report) = argv[i];
+        }
+        else if (arg == "--kernel")
+        {
+            KernelVariant variant;
+            if (++i >= argc || !parse_kernel_variant(argv[i], variant))
+            {
+                std::cerr << "Fehler: --kernel erwartet scalar, sse2 oder sse2x2" << std::endl;
+                std::exit(1);
+            }
+            set_kernel_variant(variant);
+            kernel_set = true;
+        }
+        else if (arg == "--tune")
+            tune = true;
+        else if (arg == "--profile")
+        {
+            if (++i >= argc)
+            {
+                std::cerr << "Fehler: fehlender Wert für --profile" << std::endl;
+                std::exit(1);
+            }
+            profile_path = argv[i];
+        }
+        else if (arg == "--no_profile")
+            use_profile = false;
+        else if (arg == "--io_depth")
+            io_options.queue_depth = nextIntArg(i);
+        else if (arg == "--io_mem")
+            io_options.buffer_mb = nextIntArg(i);
+        else if (arg == "--io_backend")
+        {
+            if (++i >= argc || !is_known_io_backend(argv[i]))
+            {
+                std::cerr << "Fehler: --io_backend erwartet auto, uring oder threads" << std::endl;
+                std::exit(1);
+            }
+            io_options.backend = argv[i];
+        }
+        else if (arg == "--buddhabrot" || arg == "--anti_buddhabrot")
+        {
+            buddhabrot = true;
+            buddha_options.anti = arg == "--anti_buddhabrot";
+        }
+        else if (arg == "--samples")
+            buddha_options.samples = static_cast<int64_t>(nextDoubleArg(i) * 1e6);
+        else if (arg == "--uniform")
+            buddha_options.importance = false;
+        else if (arg == "--buddha_mem")
+            buddha_options.memory_mb = nextIntArg(i);
+        else if (arg == "--seed")
+            buddha_options.seed = static_cast<uint64_t>(nextIntArg(i));
+        else if (arg == "--distance")
+            distance = true;
+        else if (arg == "--supersample")
+            distance_options.supersample = nextIntArg(i);
+        else if (arg == "--line_width")
+            distance_options.line_width = nextDoubleArg(i);
+        else if (arg == "--pfm")
+        {
+            if (++i >= argc)
+            {
+                std::cerr << "Fehler: fehlender Wert für --pfm" << std::endl;
+                std::exit(1);
+            }
+            distance_options.float_path = argv[i];
+        }
         else if (arg == "--help")
         {
             std::cout
@@ -158,13 +315,43 @@ int main(int argc, char **argv)
                 << "  --max_iter N       Iterationen (Standard: 100)\n"
                 << "  --chunk_size N     Chunk-Größe (Standard: 100)\n"
                 << "  --workers N, -j N  Worker (Standard: 3)\n"
-                << "  --filename STR     Ausgabedatei (Standard: mandelbrot.png)\n"
+                << "  --filename STR     Ausgabedatei (Standard: mandelbrot.<format>)\n"
                 << "  --intervall N      Chunk-Intervall (Standard: aus)\n"
                 << "  --offset N         Chunk-Offset (Standard: 0)\n"
                 << "  --chunk_start N    Startindex (Standard: aus)\n"
                 << "  --chunk_end N      Endindex (Standard: aus)\n"
                 << "  --fusion           Füge Chunks zusammen und speichere Bild\n"
                 << "  --delete, -t       Lösche temporäre Chunks nach dem Zusammenfügen\n"
+                << "  --numa             Worker an Kerne/NUMA-Knoten binden\n"
+                << "  --format STR       Ausgabeformat: png, qoi, ppm, raw (Standard: png)\n"
+                << "  --png_level N      zlib-Level 0-9 für PNG (Standard: libpng)\n"
+                << "  --png_strategy STR default, filtered, huffman, rle, fixed\n"
+                << "  --png_filters STR  all, none, sub, up, avg, paeth (kommagetrennt)\n"
+                << "  --bench_encode     Rendert im Speicher und misst alle Encoder\n"
+                << "  --power N          Exponent d in z^d + c (Standard: 2, max. 8)\n"
+                << "  --julia RE IM      Julia-Menge zur Konstante RE + IM*i\n"
+                << "  --burning_ship     Burning-Ship-Fraktal\n"
+                << "  --cache DIR        Kachel-Cache für wiederholte Ausschnitte (Standard: aus)\n"
+                << "  --cache_mem N      Cache-Größe im Speicher in MB (Standard: 256)\n"
+                << "  --batch FILE       Rendert alle Aufträge einer JSON-Lines-Datei\n"
+                << "  --batch_report STR Zeitbericht des Batch-Laufs (Standard: batch_report.csv)\n"
+                << "  --kernel STR       Kernel-Variante: scalar, sse2, sse2x2 (Standard: sse2)\n"
+                << "  --tune             Kalibriert Worker, Chunk-Größe und Kernel für diesen Host\n"
+                << "  --profile STR      Host-Profil (Standard: ~/.config/mandelbrot/<host>.conf)\n"
+                << "  --no_profile       Host-Profil nicht laden\n"
+                << "  --io_depth N       Ausstehende I/O-Aufträge beim Zusammenfügen (Standard: 32)\n"
+                << "  --io_mem N         Obergrenze der I/O-Puffer beim Zusammenfügen in MB (Standard: 256)\n"
+                << "  --io_backend STR   auto, uring, threads (Standard: auto)\n"
+                << "  --buddhabrot       Orbit-Dichte der entkommenden Punkte\n"
+                << "  --anti_buddhabrot  Orbit-Dichte der nicht entkommenden Punkte\n"
+                << "  --samples N        Buddhabrot-Samples in Millionen (Standard: 10)\n"
+                << "  --uniform          c-Werte gleichverteilt statt in Randnähe ziehen\n"
+                << "  --buddha_mem N     Speicher für Histogramme in MB, darüber in Bändern (Standard: 1024)\n"
+                << "  --seed N           Startwert des Zufallsgenerators (Standard: 1)\n"
+                << "  --distance         Außen-Distanzschätzung als Strichzeichnung\n"
+                << "  --supersample N    Subsamples pro Achse in Randnähe (Standard: 4)\n"
+                << "  --line_width N     Linienbreite in Pixeln (Standard: 1.0)\n"
+                << "  --pfm STR          Distanzen zusätzlich als Float-Daten (PFM) speichern\n"
                 << "  --chunk_path, -o STR Speicherpfad (Standard: chunks)\n";
             return 0;
         }
@@ -175,13 +362,116 @@ int main(int argc, char **argv)
         }
     }
 
+    if (!select_kernel(fractal))
+    {
+        std::cerr << "Fehler: --power muss zwischen " << KERNEL_MIN_POWER << " und " << KERNEL_MAX_POWER << " liegen." << std::endl;
+        return 1;
+    }
+
+    // Vor --tune, damit die Kalibrierung mit derselben Pinning-Strategie misst wie der spätere Lauf
+    numa_enable(numa);
+
+    if (tune)
+    {
+        HostProfile start;
+        start.chunk_size = chunk_size;
+        start.kernel = kernel_variant();
+        HostProfile best = tune_host(width, height, x_min, x_max, y_min, y_max, max_iter, fractal, start);
+        if (!save_host_profile(profile_path, best))
+        {
+            std::cerr << "Fehler: Konnte Profil nicht speichern: " << profile_path << std::endl;
+            return 1;
+        }
+        std::cout << "Profil gespeichert: " << profile_path << std::endl;
+        return 0;
+    }
+
+    // Kalibrierte Werte gelten nur, wenn sie nicht auf der Kommandozeile gesetzt wurden
+    HostProfile profile;
+    if (use_profile && load_host_profile(profile_path, profile))
+    {
+        std::cout << "Host-Profil: " << profile_path << std::endl;
+        if (!workers_set)
+            num_workers = profile.num_workers;
+        // Verteilte Chunk-Modi (--intervall, --chunk_start/--chunk_end, --fusion) müssen auf allen Hosts
+        // dieselbe Chunk-Größe verwenden, daher nur in Einzelprozess-Modi übernehmen
+        bool distributed = fusion || intervall != -1 || chunk_start != -1 || chunk_end != -1;
+        if (!chunk_size_set && !distributed)
+            chunk_size = profile.chunk_size;
+        if (!kernel_set)
+            set_kernel_variant(profile.kernel);
+    }
+    std::cout << "Kernel: " << kernel_variant_name(kernel_variant()) << std::endl;
+
+    std::cout << "Fraktal: " << fractal_name(fractal) << std::endl;
+
+    if (!filename_set)
+        filename = "mandelbrot." + create_encoder(encoder_options)->extension();
+
+    if (numa)
+        print_numa_topology(num_workers);
+
+    std::unique_ptr<TileCache> tile_cache;
+    if (!cache_dir.empty() && !fusion && !buddhabrot && !distance && batch_file.empty())
+    {
+        CacheGrid grid = snap_viewport(width, height, x_min, x_max, y_min, y_max);
+        std::cout << "Kachel-Cache: " << cache_dir << " (Stufe " << grid.level << ", Kachel "
+                  << TILE_SIZE << "x" << TILE_SIZE << ")" << std::endl;
+        std::cout << "Ausschnitt am Raster ausgerichtet: [" << x_min << ", " << x_max << "], ["
+                  << y_min << ", " << y_max << "]" << std::endl;
+        tile_cache = std::make_unique<TileCache>(cache_dir, cache_mem);
+        set_tile_cache(tile_cache.get());
+    }
+
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    if (chunk_start != -1 && chunk_end != -1)
+    if (!batch_file.empty())
+    {
+        BatchJob defaults{x_min, x_max, y_min, y_max, width, height, max_iter, ""};
+        std::vector<BatchJob> jobs = load_batch_jobs(batch_file, defaults);
+        std::unique_ptr<TileCache> batch_cache;
+        if (!cache_dir.empty())
+        {
+            batch_cache = std::make_unique<TileCache>(cache_dir, cache_mem);
+            set_tile_cache(batch_cache.get());
+        }
+        bool ok = run_batch(jobs, chunk_size, num_workers, encoder_options, fractal, batch_report, batch_cache != nullptr);
+        if (batch_cache)
+        {
+            set_tile_cache(nullptr);
+            batch_cache->print_stats();
+        }
+        if (!ok)
+            return 1;
+    }
+    else if (buddhabrot)
+    {
+        printParams(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers);
+        std::cout << "Dateiname: " << filename << std::endl;
+        if (!generate_buddhabrot(width, height, x_min, x_max, y_min, y_max, max_iter, num_workers, fractal,
+                                 buddha_options, filename, chunk_path, encoder_options, silent))
+            return 1;
+    }
+    else if (distance)
+    {
+        printParams(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers);
+        std::cout << "Dateiname: " << filename << std::endl;
+        if (!generate_distance(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, fractal,
+                               distance_options, filename, encoder_options, silent))
+            return 1;
+    }
+    else if (bench_encode)
+    {
+        printParams(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers);
+        cv::Mat image;
+        generate_mandelbrot_memory(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers, image, true, fractal);
+        benchmark_encoders(image, encoder_options, chunk_path);
+    }
+    else if (chunk_start != -1 && chunk_end != -1)
     {
         printParams(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers);
         chunk_limited(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size,
-                      num_workers, chunk_start, chunk_end, chunk_path, silent);
+                      num_workers, chunk_start, chunk_end, chunk_path, silent, encoder_options, fractal);
     }
     else if (chunk_start != -1 || chunk_end != -1)
     {
@@ -202,7 +492,7 @@ int main(int argc, char **argv)
             std::cout << "Intervall: " << intervall << std::endl;
             std::cout << "Offset: " << offset << std::endl;
             chunk_intervall(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size,
-                            num_workers, intervall, chunk_path, silent, offset);
+                            num_workers, intervall, chunk_path, silent, offset, encoder_options, fractal);
         }
     }
     else if (fusion)
@@ -210,13 +500,20 @@ int main(int argc, char **argv)
         std::cout << "Bildgröße: " << width << "x" << height << std::endl;
         std::cout << "Chunk-Größe: " << chunk_size << std::endl;
         std::cout << "Füge Chunks zusammen und speichere Bild..." << std::endl;
-        write_image_chunked(filename, width, height, chunk_size, chunk_path, num_workers);
+        write_image_chunked(filename, width, height, chunk_size, chunk_path, num_workers, encoder_options, io_options);
     }
     else
     {
         printParams(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers);
         chunk_unlimited(width, height, x_min, x_max, y_min, y_max, max_iter, chunk_size, num_workers,
-                        chunk_path, filename, silent, delete_cache, num_workers);
+                        chunk_path, filename, silent, delete_cache, num_workers, encoder_options, fractal, io_options);
+    }
+
+    if (tile_cache)
+    {
+        set_tile_cache(nullptr);
+        tile_cache->print_stats();
+        tile_cache.reset();
     }
 
     auto end_time = std::chrono::high_resolution_clock::now();
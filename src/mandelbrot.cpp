@@ -1,11 +1,14 @@
 #include "mandelbrot.hpp"
-#include <complex>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <vector>
 #include <filesystem>
 #include "progress.hpp"
+#include "numa.hpp"
+#include "encoder.hpp"
+#include "kernel.hpp"
+#include "tile_cache.hpp"
 
 namespace fs = std::filesystem;
 std::mutex file_mutex;
@@ -16,83 +19,99 @@ std::atomic<int> completed_chunks(0);
 ProgressBar* global_progress = nullptr;
 std::mutex global_progress_mutex;
 
-inline int mandelbrot(double cr, double ci, int max_iter) {
-    /*
-    This function basicly does this:
+TileCache* global_tile_cache = nullptr;
 
-    double zr = 0.0, zi = 0.0;
-    for (int n = 0; n < max_iter; ++n)
+void set_tile_cache(TileCache *cache)
+{
+    global_tile_cache = cache;
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Setzt den Chunk aus Rasterkacheln zusammen; nur fehlende Kacheln werden berechnet
+static void compute_chunk_cached(int y_start, int y_end, int width, double x_min, double x_max, double y_min, int max_iter, std::vector<int> &iterations, const FractalParams &fractal, RowKernel kernel)
+{
+    CacheGrid grid = grid_from_viewport(width, x_min, x_max, y_min);
+    TileKey key{grid.level, 0, 0, max_iter, fractal_signature(fractal)};
+
+    int64_t gy_first = grid.origin_y + y_start;
+    int64_t gy_last = grid.origin_y + y_end - 1;
+    int64_t gx_first = grid.origin_x;
+    int64_t gx_last = grid.origin_x + width - 1;
+
+    for (key.ty = floor_div(gy_first, TILE_SIZE); key.ty <= floor_div(gy_last, TILE_SIZE); ++key.ty)
     {
-        double zr2 = zr * zr;
-        double zi2 = zi * zi;
-        if (zr2 + zi2 > 4.0)
+        for (key.tx = floor_div(gx_first, TILE_SIZE); key.tx <= floor_div(gx_last, TILE_SIZE); ++key.tx)
         {
-            return n;
+            int64_t tile_x = key.tx * TILE_SIZE;
+            int64_t tile_y = key.ty * TILE_SIZE;
+
+            // Überlappende Chunks berechnen eine Kachel nur einmal, der zweite wartet auf das Ergebnis
+            std::shared_ptr<const TileData> tile = global_tile_cache->get_or_compute(key, [&]
+                                                                                   {
+                auto data = std::make_shared<TileData>(TILE_SIZE * TILE_SIZE);
+                for (int r = 0; r < TILE_SIZE; ++r)
+                {
+                    kernel(tile_x * grid.step, grid.step, (tile_y + r) * grid.step, TILE_SIZE, max_iter, fractal, data->data() + r * TILE_SIZE);
+                }
+                return std::shared_ptr<const TileData>(data); });
+
+            int64_t x0 = std::max(tile_x, gx_first);
+            int64_t x1 = std::min(tile_x + TILE_SIZE - 1, gx_last);
+            for (int64_t gy = std::max(tile_y, gy_first); gy <= std::min(tile_y + TILE_SIZE - 1, gy_last); ++gy)
+            {
+                const int *src = tile->data() + (gy - tile_y) * TILE_SIZE + (x0 - tile_x);
+                int *dst = iterations.data() + (gy - gy_first) * width + (x0 - gx_first);
+                std::copy(src, src + (x1 - x0 + 1), dst);
+            }
         }
-        zi = 2.0 * zr * zi + ci;
-        zr = zr2 - zi2 + cr;
     }
-    
-    */
-
-    int result;
-    const double four = 4.0;
-    __asm__ volatile(
-        "movsd %1, %%xmm0\n\t"          // cr -> xmm0
-        "movsd %2, %%xmm1\n\t"          // ci -> xmm1
-        "xorpd %%xmm2, %%xmm2\n\t"      // zr = 0
-        "xorpd %%xmm3, %%xmm3\n\t"      // zi = 0
-        "movsd %3, %%xmm7\n\t"          // Grenzwert 4.0
-        "xor %%ecx, %%ecx\n\t"          // Iterator n = 0
-        
-        "1:\n\t"                        // Schleifenstart
-        "movapd %%xmm2, %%xmm4\n\t"     // zr -> xmm4
-        "movapd %%xmm3, %%xmm5\n\t"     // zi -> xmm5
-        "mulsd %%xmm4, %%xmm4\n\t"      // zr^2
-        "mulsd %%xmm5, %%xmm5\n\t"      // zi^2
-        "movapd %%xmm4, %%xmm6\n\t"
-        "addsd %%xmm5, %%xmm6\n\t"      // zr^2 + zi^2
-        "comisd %%xmm7, %%xmm6\n\t"     // vergleiche mit 4.0
-        "ja 2f\n\t"                     // wenn > 4.0, springe zu 2
-        
-        "movapd %%xmm2, %%xmm6\n\t"
-        "mulsd %%xmm3, %%xmm6\n\t"      // zr * zi
-        "addsd %%xmm6, %%xmm6\n\t"      // 2 * zr * zi
-        "addsd %%xmm1, %%xmm6\n\t"      // + ci
-        "subsd %%xmm5, %%xmm4\n\t"      // zr^2 - zi^2
-        "addsd %%xmm0, %%xmm4\n\t"      // + cr
-        "movapd %%xmm4, %%xmm2\n\t"     // neues zr
-        "movapd %%xmm6, %%xmm3\n\t"     // neues zi
-        
-        "inc %%ecx\n\t"
-        "cmp %4, %%ecx\n\t"
-        "jl 1b\n\t"
-        
-        "2:\n\t"
-        "mov %%ecx, %0\n\t"             // Ergebnis speichern
-        : "=r" (result)
-        : "m" (cr), "m" (ci), "m" (four), "r" (max_iter)
-        : "ecx", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
-    );
-    return result;
 }
 
-void compute_chunk(int y_start, int y_end, int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, cv::Mat &image, int chunk_idx, int num_chunks, bool silent)
+// "Hot"-Colormap
+void colorize_row(const int *iterations, int width, int max_iter, uchar *rowPtr)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        double normalized = (double)iterations[x] / max_iter;
+
+        rowPtr[x * 3 + 2] = static_cast<uchar>(255 * std::min(1.0, normalized * 3.0));                  // Rot
+        rowPtr[x * 3 + 1] = static_cast<uchar>(255 * std::min(1.0, std::max(0.0, normalized - 0.33) * 3.0)); // Grün
+        rowPtr[x * 3 + 0] = static_cast<uchar>(255 * std::min(1.0, std::max(0.0, normalized - 0.66) * 3.0)); // Blau
+    }
+}
+
+void compute_chunk(int y_start, int y_end, int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, cv::Mat &image, int chunk_idx, int num_chunks, bool silent, const FractalParams &fractal, RowKernel kernel)
 {
+    std::vector<int> iterations;
+    const double dx = (x_max - x_min) / width;
+
+    if (global_tile_cache)
+    {
+        iterations.resize(static_cast<size_t>(y_end - y_start) * width);
+        compute_chunk_cached(y_start, y_end, width, x_min, x_max, y_min, max_iter, iterations, fractal, kernel);
+    }
+    else
+    {
+        iterations.resize(width);
+    }
+
     for (int y = y_start; y < y_end; ++y)
     {
         uchar* rowPtr = image.ptr<uchar>(y - y_start);
-        double imagY = y_min + (double(y) / height) * (y_max - y_min);
-        for (int x = 0; x < width; ++x)
+
+        if (global_tile_cache)
+        {
+            colorize_row(iterations.data() + static_cast<size_t>(y - y_start) * width, width, max_iter, rowPtr);
+        }
+        else
         {
-            double realX = x_min + (double(x) / width) * (x_max - x_min);
-            int value = mandelbrot(realX, imagY, max_iter);
-            double normalized = (double)value / max_iter;
-
-            // "Hot"-Colormap
-            rowPtr[x * 3 + 2] = static_cast<uchar>(255 * std::min(1.0, normalized * 3.0));                  // Rot
-            rowPtr[x * 3 + 1] = static_cast<uchar>(255 * std::min(1.0, std::max(0.0, normalized - 0.33) * 3.0)); // Grün
-            rowPtr[x * 3 + 0] = static_cast<uchar>(255 * std::min(1.0, std::max(0.0, normalized - 0.66) * 3.0)); // Blau
+            double imagY = y_min + (double(y) / height) * (y_max - y_min);
+            kernel(x_min, dx, imagY, width, max_iter, fractal, iterations.data());
+            colorize_row(iterations.data(), width, max_iter, rowPtr);
         }
 
         if (!silent) {
@@ -109,8 +128,10 @@ void compute_chunk(int y_start, int y_end, int width, int height, double x_min,
     }
 }
 
-void generate_mandelbrot_chunked(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, bool silent)
+void generate_mandelbrot_chunked(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, std::string temp_dir, bool silent, const EncoderOptions &encoder_options, const FractalParams &fractal)
 {
+    RowKernel kernel = select_kernel(fractal);
+
     namespace fs = std::filesystem;
     if (!fs::exists(temp_dir))
     {
@@ -118,7 +139,6 @@ void generate_mandelbrot_chunked(int width, int height, double x_min, double x_m
     }
 
     std::vector<std::thread> threads;
-    std::mutex file_mutex;
     int num_chunks = (height + chunk_size - 1) / chunk_size;
 
     std::cout << "Anzahl der Chunks: " << num_chunks << std::endl;
@@ -132,18 +152,20 @@ void generate_mandelbrot_chunked(int width, int height, double x_min, double x_m
         int y_start = chunk_idx * chunk_size;
         int y_end = std::min((chunk_idx + 1) * chunk_size, height);
 
-        threads.emplace_back([=, &file_mutex]()
+        threads.emplace_back([=, &encoder_options, &fractal, slot = static_cast<int>(threads.size())]()
                              {
                                  try {
+                                     // Erst pinnen, dann allozieren: der Chunk-Puffer landet so auf dem lokalen Knoten
+                                     numa_pin_worker(slot);
+
                                      cv::Mat image(y_end - y_start, width, CV_8UC3, cv::Scalar(0, 0, 0));
 
-                                     compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_chunks, silent);
+                                     compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_chunks, silent, fractal, kernel);
 
-                                     {
-                                         std::lock_guard<std::mutex> lock(file_mutex);
-                                         std::string filename = temp_dir + "/chunk_" + std::to_string(chunk_idx) + ".png";
-                                         cv::imwrite(filename, image);
-                                     }
+                                     auto encoder = create_encoder(encoder_options);
+                                     std::string filename = temp_dir + "/chunk_" + std::to_string(chunk_idx) + "." + encoder->extension();
+                                     if (!encoder->write(filename, image))
+                                         std::cerr << "Fehler: Konnte " << filename << " nicht schreiben." << std::endl;
                                  } catch (const std::exception &e) {
                                      std::cerr << "Fehler im Thread " << chunk_idx << ": " << e.what() << std::endl;
                                  } catch (...) {
@@ -169,8 +191,10 @@ void generate_mandelbrot_chunked(int width, int height, double x_min, double x_m
     }
 }
 
-void generate_mandelbrot_limited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string out_dir, bool silent)
+void generate_mandelbrot_limited(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int chunk_start, int chunk_end, std::string out_dir, bool silent, const EncoderOptions &encoder_options, const FractalParams &fractal)
 {
+    RowKernel kernel = select_kernel(fractal);
+
     namespace fs = std::filesystem;
     if (!fs::exists(out_dir))
     {
@@ -178,7 +202,6 @@ void generate_mandelbrot_limited(int width, int height, double x_min, double x_m
     }
 
     std::vector<std::thread> threads;
-    std::mutex file_mutex;
     int num_chunks = (height + chunk_size - 1) / chunk_size;
     int num_active_chunks = chunk_end - chunk_start + 1;
 
@@ -191,18 +214,20 @@ void generate_mandelbrot_limited(int width, int height, double x_min, double x_m
 
         if (chunk_idx >= chunk_start && chunk_idx < chunk_end)
         {
-            threads.emplace_back([=, &file_mutex]()
+            threads.emplace_back([=, &encoder_options, &fractal, slot = static_cast<int>(threads.size())]()
                                  {
                                      try {
+                                         // Erst pinnen, dann allozieren: der Chunk-Puffer landet so auf dem lokalen Knoten
+                                         numa_pin_worker(slot);
+
                                          cv::Mat image(y_end - y_start, width, CV_8UC3, cv::Scalar(0, 0, 0));
 
-                                         compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_active_chunks, silent);
+                                         compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_active_chunks, silent, fractal, kernel);
 
-                                         {
-                                             std::lock_guard<std::mutex> lock(file_mutex);
-                                             std::string filename = out_dir + "/chunk_" + std::to_string(chunk_idx) + ".png";
-                                             cv::imwrite(filename, image);
-                                         }
+                                         auto encoder = create_encoder(encoder_options);
+                                         std::string filename = out_dir + "/chunk_" + std::to_string(chunk_idx) + "." + encoder->extension();
+                                         if (!encoder->write(filename, image))
+                                             std::cerr << "Fehler: Konnte " << filename << " nicht schreiben." << std::endl;
                                      } catch (const std::exception &e) {
                                          std::cerr << "Fehler im Thread " << chunk_idx << ": " << e.what() << std::endl;
                                      } catch (...) {
@@ -224,8 +249,10 @@ void generate_mandelbrot_limited(int width, int height, double x_min, double x_m
     }
 }
 
-void generate_mandelbrot_intervall(int width, int height, int x_min, int x_max, int y_min, int y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string out_path, bool silent, int offset)
+void generate_mandelbrot_intervall(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, int intervall, std::string out_path, bool silent, int offset, const EncoderOptions &encoder_options, const FractalParams &fractal)
 {
+    RowKernel kernel = select_kernel(fractal);
+
     namespace fs = std::filesystem;
     if (!fs::exists(out_path))
     {
@@ -233,7 +260,6 @@ void generate_mandelbrot_intervall(int width, int height, int x_min, int x_max,
     }
 
     std::vector<std::thread> threads;
-    std::mutex file_mutex;
     int num_chunks = (height + chunk_size - 1) / chunk_size;
     int num_active_chunks = (num_chunks + intervall - 1) / intervall;
 
@@ -246,18 +272,20 @@ void generate_mandelbrot_intervall(int width, int height, int x_min, int x_max,
 
         if ((chunk_idx + offset) % intervall == 0)
         {
-            threads.emplace_back([=, &file_mutex]()
+            threads.emplace_back([=, &encoder_options, &fractal, slot = static_cast<int>(threads.size())]()
                                  {
                                      try {
+                                         // Erst pinnen, dann allozieren: der Chunk-Puffer landet so auf dem lokalen Knoten
+                                         numa_pin_worker(slot);
+
                                          cv::Mat image(y_end - y_start, width, CV_8UC3, cv::Scalar(0, 0, 0));
 
-                                         compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_active_chunks, silent);
+                                         compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, image, chunk_idx, num_active_chunks, silent, fractal, kernel);
 
-                                         {
-                                             std::lock_guard<std::mutex> lock(file_mutex);
-                                             std::string filename = out_path + "/chunk_" + std::to_string(chunk_idx) + ".png";
-                                             cv::imwrite(filename, image);
-                                         }
+                                         auto encoder = create_encoder(encoder_options);
+                                         std::string filename = out_path + "/chunk_" + std::to_string(chunk_idx) + "." + encoder->extension();
+                                         if (!encoder->write(filename, image))
+                                             std::cerr << "Fehler: Konnte " << filename << " nicht schreiben." << std::endl;
                                      } catch (const std::exception &e) {
                                          std::cerr << "Fehler im Thread " << chunk_idx << ": " << e.what() << std::endl;
                                      } catch (...) {
@@ -277,4 +305,38 @@ void generate_mandelbrot_intervall(int width, int height, int x_min, int x_max,
             threads.clear();
         }
     }
-}
\ No newline at end of file
+}
+void generate_mandelbrot_memory(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, int chunk_size, int num_workers, cv::Mat &image, bool silent, const FractalParams &fractal)
+{
+    RowKernel kernel = select_kernel(fractal);
+
+    std::vector<std::thread> threads;
+    int num_chunks = (height + chunk_size - 1) / chunk_size;
+
+    image.create(height, width, CV_8UC3);
+
+    for (int chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx)
+    {
+        int y_start = chunk_idx * chunk_size;
+        int y_end = std::min((chunk_idx + 1) * chunk_size, height);
+
+        threads.emplace_back([=, &image, &fractal, slot = static_cast<int>(threads.size())]()
+                             {
+                                 numa_pin_worker(slot);
+
+                                 cv::Mat rows = image.rowRange(y_start, y_end);
+                                 compute_chunk(y_start, y_end, width, height, x_min, x_max, y_min, y_max, max_iter, rows, chunk_idx, num_chunks, silent, fractal, kernel); });
+
+        if (threads.size() == num_workers || chunk_idx == num_chunks - 1)
+        {
+            for (auto &t : threads)
+            {
+                if (t.joinable())
+                {
+                    t.join();
+                }
+            }
+            threads.clear();
+        }
+    }
+}
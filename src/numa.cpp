@@ -0,0 +1,210 @@
+#include "numa.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+namespace fs = std::filesystem;
+
+static bool numa_active = false;
+
+// Parst Listen im sysfs-Format, z.B. "0-3,8-11"
+static std::vector<int> parse_cpulist(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ','))
+    {
+        if (part.empty() || part == "\n")
+            continue;
+        size_t dash = part.find('-');
+        try
+        {
+            if (dash == std::string::npos)
+            {
+                cpus.push_back(std::stoi(part));
+            }
+            else
+            {
+                int first = std::stoi(part.substr(0, dash));
+                int last = std::stoi(part.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+        }
+        catch (const std::exception &)
+        {
+            // Unlesbare Einträge ignorieren
+        }
+    }
+    return cpus;
+}
+
+static std::string read_first_line(const std::string &path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// Erster Hyperthread eines physischen Kerns?
+static bool is_primary_thread(int cpu)
+{
+    std::string siblings = read_first_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+    std::vector<int> list = parse_cpulist(siblings);
+    return list.empty() || *std::min_element(list.begin(), list.end()) == cpu;
+}
+
+NumaTopology detect_numa_topology()
+{
+    NumaTopology topo;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto usable = [&](int cpu)
+    {
+        return cpu >= 0 && cpu < CPU_SETSIZE && (!have_mask || CPU_ISSET(cpu, &allowed));
+    };
+
+    const std::string node_root = "/sys/devices/system/node";
+    std::error_code ec;
+    if (fs::exists(node_root, ec))
+    {
+        for (const auto &entry : fs::directory_iterator(node_root, ec))
+        {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() <= 4 || !std::isdigit(static_cast<unsigned char>(name[4])))
+                continue;
+
+            NumaNode node;
+            node.id = std::stoi(name.substr(4));
+            for (int cpu : parse_cpulist(read_first_line(entry.path().string() + "/cpulist")))
+            {
+                if (usable(cpu))
+                    node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty())
+                topo.nodes.push_back(node);
+        }
+    }
+
+    if (topo.nodes.empty())
+    {
+        NumaNode node{0, {}};
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (have_mask ? CPU_ISSET(cpu, &allowed) : cpu < static_cast<int>(std::thread::hardware_concurrency()))
+                node.cpus.push_back(cpu);
+        }
+        if (node.cpus.empty())
+            node.cpus.push_back(0);
+        topo.nodes.push_back(node);
+    }
+
+    std::sort(topo.nodes.begin(), topo.nodes.end(),
+              [](const NumaNode &a, const NumaNode &b)
+              { return a.id < b.id; });
+
+    // Pro Knoten zuerst physische Kerne, danach deren Hyperthreads
+    std::vector<std::vector<int>> ordered(topo.nodes.size());
+    for (size_t n = 0; n < topo.nodes.size(); ++n)
+    {
+        std::vector<int> siblings;
+        for (int cpu : topo.nodes[n].cpus)
+        {
+            if (is_primary_thread(cpu))
+                ordered[n].push_back(cpu);
+            else
+                siblings.push_back(cpu);
+        }
+        ordered[n].insert(ordered[n].end(), siblings.begin(), siblings.end());
+    }
+
+    // Worker abwechselnd auf die Knoten verteilen, damit alle Sockel genutzt werden
+    size_t longest = 0;
+    for (const auto &cpus : ordered)
+        longest = std::max(longest, cpus.size());
+    for (size_t i = 0; i < longest; ++i)
+    {
+        for (size_t n = 0; n < ordered.size(); ++n)
+        {
+            if (i < ordered[n].size())
+            {
+                topo.worker_cpus.push_back(ordered[n][i]);
+                topo.worker_nodes.push_back(static_cast<int>(n));
+            }
+        }
+    }
+
+    return topo;
+}
+
+void numa_enable(bool enabled)
+{
+    numa_active = enabled;
+}
+
+const NumaTopology &numa_topology()
+{
+    static NumaTopology topo = detect_numa_topology();
+    return topo;
+}
+
+int numa_node_count()
+{
+    return numa_active ? static_cast<int>(numa_topology().nodes.size()) : 1;
+}
+
+int numa_pin_worker(int slot)
+{
+    if (!numa_active)
+        return 0;
+
+    const NumaTopology &topo = numa_topology();
+    size_t idx = slot % topo.worker_cpus.size();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(topo.worker_cpus[idx], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        static std::once_flag warned;
+        std::call_once(warned, []
+                       { std::cerr << "Warnung: Konnte Worker nicht an CPU binden." << std::endl; });
+    }
+    return topo.worker_nodes[idx];
+}
+
+void print_numa_topology(int num_workers)
+{
+    if (!numa_active)
+        return;
+
+    const NumaTopology &topo = numa_topology();
+    std::cout << "NUMA-Knoten: " << topo.nodes.size() << std::endl;
+    for (const auto &node : topo.nodes)
+    {
+        std::cout << "  Knoten " << node.id << ": " << node.cpus.size() << " CPUs [";
+        for (size_t i = 0; i < node.cpus.size(); ++i)
+            std::cout << (i ? "," : "") << node.cpus[i];
+        std::cout << "]" << std::endl;
+    }
+
+    std::cout << "Worker-Zuordnung:";
+    for (int slot = 0; slot < num_workers; ++slot)
+    {
+        size_t idx = slot % topo.worker_cpus.size();
+        std::cout << " " << slot << "->CPU" << topo.worker_cpus[idx]
+                  << "/N" << topo.nodes[topo.worker_nodes[idx]].id;
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,303 @@
+#include "tile_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+double grid_step(int level)
+{
+    return std::exp2(-double(level) / LEVELS_PER_OCTAVE);
+}
+
+CacheGrid grid_from_viewport(int width, double x_min, double x_max, double y_min)
+{
+    CacheGrid grid;
+    grid.level = static_cast<int>(std::lround(-std::log2((x_max - x_min) / width) * LEVELS_PER_OCTAVE));
+    grid.step = grid_step(grid.level);
+    grid.origin_x = std::llround(x_min / grid.step);
+    grid.origin_y = std::llround(y_min / grid.step);
+    return grid;
+}
+
+CacheGrid snap_viewport(int width, int height, double &x_min, double &x_max, double &y_min, double &y_max)
+{
+    CacheGrid grid = grid_from_viewport(width, x_min, x_max, y_min);
+
+    // Quadratische Pixel, Mittelpunkt des gewünschten Ausschnitts beibehalten
+    double cx = 0.5 * (x_min + x_max);
+    double cy = 0.5 * (y_min + y_max);
+    grid.origin_x = std::llround(cx / grid.step - width / 2.0);
+    grid.origin_y = std::llround(cy / grid.step - height / 2.0);
+
+    x_min = grid.origin_x * grid.step;
+    x_max = (grid.origin_x + width) * grid.step;
+    y_min = grid.origin_y * grid.step;
+    y_max = (grid.origin_y + height) * grid.step;
+    return grid;
+}
+
+size_t TileKeyHash::operator()(const TileKey &k) const
+{
+    uint64_t h = k.fractal;
+    auto mix = [&h](uint64_t v)
+    {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    };
+    mix(static_cast<uint64_t>(k.level));
+    mix(static_cast<uint64_t>(k.tx));
+    mix(static_cast<uint64_t>(k.ty));
+    mix(static_cast<uint64_t>(k.max_iter));
+    return static_cast<size_t>(h);
+}
+
+uint64_t fractal_signature(const FractalParams &params)
+{
+    // FNV-1a über die Parameter, die das Ergebnis beeinflussen
+    uint64_t h = 1469598103934665603ULL;
+    auto feed = [&h](const void *data, size_t size)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+    };
+    int formula = static_cast<int>(params.formula);
+    feed(&formula, sizeof(formula));
+    feed(&params.power, sizeof(params.power));
+    if (params.formula == Formula::Julia)
+    {
+        feed(&params.julia_re, sizeof(params.julia_re));
+        feed(&params.julia_im, sizeof(params.julia_im));
+    }
+    return h;
+}
+
+TileCache::TileCache(const std::string &dir, size_t memory_mb)
+    : dir(dir)
+{
+    size_t tile_bytes = sizeof(int) * TILE_SIZE * TILE_SIZE;
+    capacity = std::max<size_t>(1, memory_mb * 1024 * 1024 / tile_bytes);
+    fs::create_directories(dir);
+}
+
+TileCache::~TileCache()
+{
+    flush();
+}
+
+std::string TileCache::tile_path(const TileKey &key) const
+{
+    std::ostringstream path;
+    path << dir << "/L" << key.level << "_" << std::hex << key.fractal << std::dec
+         << "_i" << key.max_iter << "/" << key.tx << "_" << key.ty << ".tile";
+    return path.str();
+}
+
+bool TileCache::write_tile(const TileKey &key, const TileData &data)
+{
+    std::string path = tile_path(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    // Erst temporär schreiben und umbenennen, damit parallele Läufe nie halbe Kacheln sehen;
+    // Prozess- und Thread-ID machen den Namen auch zwischen Prozessen eindeutig
+    std::ostringstream tmp;
+    tmp << path << ".tmp" << getpid() << "_" << std::this_thread::get_id();
+    FILE *fp = fopen(tmp.str().c_str(), "wb");
+    if (!fp)
+        return false;
+    bool ok = fwrite(data.data(), sizeof(int), data.size(), fp) == data.size();
+    ok = fclose(fp) == 0 && ok;
+    if (ok)
+        fs::rename(tmp.str(), path, ec);
+    if (!ok || ec)
+    {
+        fs::remove(tmp.str(), ec);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const TileData> TileCache::read_tile(const TileKey &key)
+{
+    FILE *fp = fopen(tile_path(key).c_str(), "rb");
+    if (!fp)
+        return nullptr;
+
+    auto data = std::make_shared<TileData>(TILE_SIZE * TILE_SIZE);
+    bool ok = fread(data->data(), sizeof(int), data->size(), fp) == data->size();
+    fclose(fp);
+    return ok ? data : nullptr;
+}
+
+void TileCache::insert_locked(const TileKey &key, std::shared_ptr<const TileData> data, bool on_disk, SpillList &victims)
+{
+    auto it = tiles.find(key);
+    if (it != tiles.end())
+    {
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return;
+    }
+    lru.push_front(key);
+    tiles[key] = {std::move(data), on_disk, lru.begin()};
+    evict_locked(victims);
+}
+
+void TileCache::evict_locked(SpillList &victims)
+{
+    while (tiles.size() > capacity)
+    {
+        TileKey victim = lru.back();
+        auto it = tiles.find(victim);
+        if (!it->second.on_disk)
+        {
+            spilling[victim] = it->second.data;
+            victims.emplace_back(victim, it->second.data);
+        }
+        lru.pop_back();
+        tiles.erase(it);
+    }
+}
+
+void TileCache::spill(const SpillList &victims)
+{
+    for (const auto &[key, data] : victims)
+    {
+        bool ok = write_tile(key, *data);
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = spilling.find(key);
+        if (it != spilling.end() && it->second == data)
+            spilling.erase(it);
+        if (ok)
+            spilled++;
+    }
+}
+
+std::shared_ptr<const TileData> TileCache::get(const TileKey &key)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = tiles.find(key);
+        if (it != tiles.end())
+        {
+            lru.splice(lru.begin(), lru, it->second.lru);
+            memory_hits++;
+            return it->second.data;
+        }
+        auto pending = spilling.find(key);
+        if (pending != spilling.end())
+        {
+            memory_hits++;
+            return pending->second;
+        }
+    }
+
+    // Plattenzugriff außerhalb der Sperre
+    auto data = read_tile(key);
+    if (!data)
+    {
+        misses++;
+        return nullptr;
+    }
+
+    disk_hits++;
+    SpillList victims;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        insert_locked(key, data, true, victims);
+    }
+    spill(victims);
+    return data;
+}
+
+std::shared_ptr<const TileData> TileCache::get_or_compute(const TileKey &key, const std::function<std::shared_ptr<const TileData>()> &compute)
+{
+    if (auto data = get(key))
+        return data;
+
+    std::promise<std::shared_ptr<const TileData>> promise;
+    std::shared_future<std::shared_ptr<const TileData>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = tiles.find(key);
+        if (it != tiles.end())
+            return it->second.data; // inzwischen von einem anderen Chunk abgelegt
+
+        auto flight = in_flight.find(key);
+        if (flight != in_flight.end())
+        {
+            pending = flight->second;
+        }
+        else
+        {
+            in_flight.emplace(key, promise.get_future().share());
+        }
+    }
+
+    if (pending.valid())
+    {
+        misses--;
+        joined++;
+        return pending.get();
+    }
+
+    auto data = compute();
+    SpillList victims;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        insert_locked(key, data, false, victims);
+        in_flight.erase(key);
+    }
+    promise.set_value(data);
+    spill(victims);
+    return data;
+}
+
+void TileCache::flush()
+{
+    // Kandidaten unter der Sperre einsammeln, geschrieben wird ohne Sperre
+    SpillList dirty;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &[key, entry] : tiles)
+        {
+            if (!entry.on_disk)
+            {
+                entry.on_disk = true;
+                dirty.emplace_back(key, entry.data);
+            }
+        }
+    }
+
+    for (const auto &[key, data] : dirty)
+    {
+        if (write_tile(key, *data))
+            continue;
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = tiles.find(key);
+        if (it != tiles.end())
+            it->second.on_disk = false;
+    }
+}
+
+void TileCache::print_stats()
+{
+    uint64_t mem = memory_hits, disk = disk_hits, miss = misses, join = joined;
+    uint64_t total = mem + disk + miss + join;
+    double rate = total ? 100.0 * (mem + disk + join) / total : 0.0;
+
+    std::cout << "Kachel-Cache: " << total << " Zugriffe, "
+              << mem << " Treffer (Speicher), " << disk << " Treffer (Platte), "
+              << join << " abgewartet, " << miss << " berechnet, " << spilled << " ausgelagert ("
+              << std::fixed << std::setprecision(1) << rate << "% Trefferquote)" << std::endl;
+}
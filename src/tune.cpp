@@ -0,0 +1,171 @@
+#include "tune.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "mandelbrot.hpp"
+
+namespace fs = std::filesystem;
+
+std::string host_profile_path()
+{
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+
+    std::string base;
+    if (const char *xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg)
+        base = xdg;
+    else if (const char *home = std::getenv("HOME"); home && *home)
+        base = std::string(home) + "/.config";
+    else
+        base = ".";
+    return base + "/mandelbrot/" + host + ".conf";
+}
+
+bool load_host_profile(const std::string &path, HostProfile &profile)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            continue;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        try
+        {
+            if (key == "workers")
+                profile.num_workers = std::max(1, std::stoi(value));
+            else if (key == "chunk_size")
+                profile.chunk_size = std::max(1, std::stoi(value));
+            else if (key == "kernel" && !parse_kernel_variant(value, profile.kernel))
+                std::cerr << "Warnung: unbekannte Kernel-Variante im Profil: " << value << std::endl;
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Warnung: ungültige Zeile im Profil: " << line << std::endl;
+        }
+    }
+    return true;
+}
+
+bool save_host_profile(const std::string &path, const HostProfile &profile)
+{
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::time_t now = std::time(nullptr);
+    out << "# Erzeugt von mandelbrot --tune am " << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M") << "\n"
+        << "# " << std::thread::hardware_concurrency() << " logische CPUs\n"
+        << "workers=" << profile.num_workers << "\n"
+        << "chunk_size=" << profile.chunk_size << "\n"
+        << "kernel=" << kernel_variant_name(profile.kernel) << "\n";
+    return static_cast<bool>(out);
+}
+
+HostProfile tune_host(int width, int height, double x_min, double x_max, double y_min, double y_max, int max_iter, const FractalParams &fractal, const HostProfile &start)
+{
+    // Repräsentative, aber kurze Last: gleicher Ausschnitt, höchstens 1200 Pixel breit
+    int w = std::min(width, 1200);
+    int h = std::max(1, static_cast<int>(int64_t(height) * w / width));
+
+    KernelVariant saved_variant = kernel_variant();
+    cv::Mat image;
+
+    auto measure = [&](const HostProfile &p)
+    {
+        set_kernel_variant(p.kernel);
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            generate_mandelbrot_memory(w, h, x_min, x_max, y_min, y_max, max_iter, p.chunk_size, p.num_workers, image, true, fractal);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        }
+        std::cout << "  Worker " << std::setw(3) << p.num_workers
+                  << "  Chunk " << std::setw(4) << p.chunk_size
+                  << "  Kernel " << std::setw(7) << kernel_variant_name(p.kernel)
+                  << "  " << std::fixed << std::setprecision(4) << best << " s" << std::endl;
+        return best;
+    };
+
+    HostProfile best = start;
+    int cpus = std::max(1u, std::thread::hardware_concurrency());
+    best.num_workers = cpus;
+    best.chunk_size = std::min(start.chunk_size, h);
+    std::cout << "Kalibrierung auf " << w << "x" << h << ", " << max_iter << " Iterationen" << std::endl;
+    double best_time = measure(best);
+
+    auto try_candidate = [&](HostProfile candidate)
+    {
+        double t = measure(candidate);
+        if (t < best_time)
+        {
+            best_time = t;
+            best = candidate;
+        }
+    };
+
+    std::cout << "Kernel-Varianten:" << std::endl;
+    for (KernelVariant v : {KernelVariant::Scalar, KernelVariant::SSE2, KernelVariant::SSE2x2})
+    {
+        if (v == best.kernel)
+            continue;
+        HostProfile candidate = best;
+        candidate.kernel = v;
+        try_candidate(candidate);
+    }
+
+    std::cout << "Worker-Anzahl:" << std::endl;
+    std::vector<int> workers;
+    for (int n = 1; n <= 2 * cpus; n *= 2)
+        workers.push_back(n);
+    workers.push_back(cpus);
+    workers.push_back(cpus + cpus / 2);
+    std::sort(workers.begin(), workers.end());
+    workers.erase(std::unique(workers.begin(), workers.end()), workers.end());
+    int tested_workers = best.num_workers;
+    for (int n : workers)
+    {
+        if (n == tested_workers)
+            continue;
+        HostProfile candidate = best;
+        candidate.num_workers = n;
+        try_candidate(candidate);
+    }
+
+    std::cout << "Chunk-Größe:" << std::endl;
+    int tested_chunk = best.chunk_size;
+    for (int size : {10, 25, 50, 100, 200, 400})
+    {
+        if (size > h || size == tested_chunk)
+            continue;
+        HostProfile candidate = best;
+        candidate.chunk_size = size;
+        try_candidate(candidate);
+    }
+
+    set_kernel_variant(saved_variant);
+
+    std::cout << "Beste Einstellung: " << best.num_workers << " Worker, Chunk-Größe " << best.chunk_size
+              << ", Kernel " << kernel_variant_name(best.kernel)
+              << " (" << std::fixed << std::setprecision(4) << best_time << " s)" << std::endl;
+    return best;
+}